@@ -0,0 +1,140 @@
+#pragma once
+
+#include "dijkstra.h"
+#include "router.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+// Флаги дуги - по биту на ячейку разбиения вершин
+using ArcFlags = uint64_t;
+
+const size_t MAX_ARC_FLAG_CELLS = 64;
+
+// Бит ячейки c у ребра поднят, если ребро лежит на кратчайшем пути в какую-нибудь вершину ячейки c.
+// Рёбра внутри ячейки помечаются ею всегда. Для остальных строятся обратные деревья кратчайших путей
+// от граничных вершин ячейки (в них входят рёбра из других ячеек): любой кратчайший путь в ячейку
+// можно заменить путём по дереву до последнего входа в неё и дальше по рёбрам внутри неё
+template <typename Weight>
+std::vector<ArcFlags> ComputeArcFlags(const DirectedWeightedGraph<Weight>& graph, const std::vector<uint32_t>& vertex_cells) {
+    if (vertex_cells.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Cells are required for every vertex");
+    }
+
+    std::vector<ArcFlags> flags(graph.GetEdgeCount(), 0);
+    std::vector<bool> is_boundary(graph.GetVertexCount(), false);
+
+    // Обратный граф с теми же номерами рёбер
+    DirectedWeightedGraph<Weight> reversed(graph.GetVertexCount());
+
+    for (EdgeId id = 0; id < graph.GetEdgeCount(); ++id) {
+        const auto& edge = graph.GetEdge(id);
+        if (vertex_cells[edge.to] >= MAX_ARC_FLAG_CELLS) {
+            throw std::out_of_range("Too many arc flag cells");
+        }
+
+        reversed.AddEdge({edge.to, edge.from, edge.weight});
+
+        if (vertex_cells[edge.from] == vertex_cells[edge.to]) {
+            flags[id] |= ArcFlags{1} << vertex_cells[edge.to];
+        }
+        else {
+            is_boundary[edge.to] = true;
+        }
+    }
+
+    for (VertexId boundary = 0; boundary < graph.GetVertexCount(); ++boundary) {
+        if (!is_boundary[boundary]) {
+            continue;
+        }
+
+        const ArcFlags cell_flag = ArcFlags{1} << vertex_cells[boundary];
+        const auto tree = BuildShortestPathTree(reversed, boundary);
+
+        for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+            if (tree.prev_edges[vertex] != tree.NO_EDGE) {
+                flags[tree.prev_edges[vertex]] |= cell_flag;
+            }
+        }
+    }
+    return flags;
+}
+
+// Поиск Дейкстры от начала до конца маршрута только по рёбрам, помеченным ячейкой конца.
+// Ничего не хранит между запросами, кроме графа и флагов. Queue - очередь поиска, как у LazyRouter
+template <typename Weight, typename Queue = DijkstraQueue<Weight>>
+class ArcFlagRouter : public RouterEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterEngine<Weight>::RouteInfo;
+    using EdgeVisitor = typename RouterEngine<Weight>::EdgeVisitor;
+
+    ArcFlagRouter(const Graph& graph, std::vector<uint32_t> vertex_cells, std::vector<ArcFlags> edge_flags, Queue queue = {});
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const override;
+    std::optional<Weight> VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const override;
+
+private:
+    ShortestPathTree<Weight> Search(VertexId from, VertexId to) const;
+
+    const Graph& graph_;
+    std::vector<uint32_t> vertex_cells_;
+    std::vector<ArcFlags> edge_flags_;
+    Queue queue_;
+};
+
+template <typename Weight, typename Queue>
+ArcFlagRouter<Weight, Queue>::ArcFlagRouter(const Graph& graph, std::vector<uint32_t> vertex_cells, std::vector<ArcFlags> edge_flags, Queue queue)
+    : graph_(graph)
+    , vertex_cells_(std::move(vertex_cells))
+    , edge_flags_(std::move(edge_flags))
+    , queue_(std::move(queue))
+{
+    if (vertex_cells_.size() != graph.GetVertexCount() || edge_flags_.size() != graph.GetEdgeCount()) {
+        throw std::invalid_argument("Arc flags do not match the graph");
+    }
+}
+
+template <typename Weight, typename Queue>
+std::optional<typename ArcFlagRouter<Weight, Queue>::RouteInfo> ArcFlagRouter<Weight, Queue>::BuildRoute(VertexId from, VertexId to) const {
+    const auto tree = Search(from, to);
+    if (!tree.IsReachable(to)) {
+        return std::nullopt;
+    }
+    return RouteInfo{tree.weights[to], tree.GetPathEdges(graph_, to)};
+}
+
+template <typename Weight, typename Queue>
+std::optional<Weight> ArcFlagRouter<Weight, Queue>::GetRouteWeight(VertexId from, VertexId to) const {
+    const auto tree = Search(from, to);
+    if (!tree.IsReachable(to)) {
+        return std::nullopt;
+    }
+    return tree.weights[to];
+}
+
+template <typename Weight, typename Queue>
+std::optional<Weight> ArcFlagRouter<Weight, Queue>::VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const {
+    const auto tree = Search(from, to);
+    if (!tree.IsReachable(to)) {
+        return std::nullopt;
+    }
+    tree.VisitPathEdges(graph_, to, visitor);
+    return tree.weights[to];
+}
+
+template <typename Weight, typename Queue>
+ShortestPathTree<Weight> ArcFlagRouter<Weight, Queue>::Search(VertexId from, VertexId to) const {
+    const ArcFlags target_flag = ArcFlags{1} << vertex_cells_.at(to);
+
+    return BuildShortestPathTree(graph_, from, std::optional<Weight>(), std::optional<VertexId>(to),
+                                 [this, target_flag](EdgeId edge_id) { return (edge_flags_[edge_id] & target_flag) != 0; }, queue_);
+}
+
+}  // namespace graph
@@ -0,0 +1,430 @@
+#include "columnar.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace serialization {
+
+    namespace {
+
+        // Флаги маршрута в столбце bus_flags
+        const uint32_t COLUMNAR_BUS_ROUNDTRIP = 1;
+        const uint32_t COLUMNAR_BUS_MIRRORED = 2;      // хранится прямой ход, обратный восстанавливается отражением
+        const uint32_t COLUMNAR_BUS_FLAGS_WIDTH = 2;
+
+        [[noreturn]] void ThrowCorrupted() {
+            throw std::runtime_error("columnar catalogue is corrupted");
+        }
+
+        uint64_t ZigZag(int64_t value) {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        int64_t UnZigZag(uint64_t value) {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        // Число бит для значений от 0 до max_value
+        uint32_t BitWidth(uint64_t max_value) {
+            uint32_t width = 0;
+            for (; max_value > 0; max_value >>= 1) {
+                ++width;
+            }
+            return width;
+        }
+
+        void PutVarint(std::string& out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        // Последовательное чтение столбца varint и байтов с проверкой границ
+        class ColumnReader {
+        public:
+            explicit ColumnReader(std::string_view data)
+                : data_(data) {
+            }
+
+            uint64_t GetVarint() {
+                uint64_t value = 0;
+                for (uint32_t shift = 0; shift < 64; shift += 7) {
+                    if (pos_ >= data_.size()) {
+                        ThrowCorrupted();
+                    }
+                    const auto byte = static_cast<uint8_t>(data_[pos_++]);
+                    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                ThrowCorrupted();
+            }
+
+            std::string_view GetBytes(uint64_t size) {
+                if (size > data_.size() - pos_) {
+                    ThrowCorrupted();
+                }
+                const auto bytes = data_.substr(pos_, size);
+                pos_ += size;
+                return bytes;
+            }
+
+        private:
+            std::string_view data_;
+            size_t pos_ = 0;
+        };
+
+        // Битовая упаковка значений до 32 бит, младшие биты - первыми
+        class BitWriter {
+        public:
+            void Put(uint32_t value, uint32_t width) {
+                buffer_ |= static_cast<uint64_t>(value) << bits_;
+                bits_ += width;
+                for (; bits_ >= 8; bits_ -= 8) {
+                    data_.push_back(static_cast<char>(buffer_ & 0xFF));
+                    buffer_ >>= 8;
+                }
+            }
+
+            std::string Finish() {
+                if (bits_ > 0) {
+                    data_.push_back(static_cast<char>(buffer_ & 0xFF));
+                }
+                buffer_ = 0;
+                bits_ = 0;
+                return std::move(data_);
+            }
+
+        private:
+            std::string data_;
+            uint64_t buffer_ = 0;
+            uint32_t bits_ = 0;
+        };
+
+        class BitReader {
+        public:
+            explicit BitReader(std::string_view data)
+                : data_(data) {
+            }
+
+            uint32_t Get(uint32_t width) {
+                for (; bits_ < width; bits_ += 8) {
+                    if (pos_ >= data_.size()) {
+                        ThrowCorrupted();
+                    }
+                    buffer_ |= static_cast<uint64_t>(static_cast<uint8_t>(data_[pos_++])) << bits_;
+                }
+                const auto value = static_cast<uint32_t>(buffer_ & ((uint64_t{ 1 } << width) - 1));
+                buffer_ >>= width;
+                bits_ -= width;
+                return value;
+            }
+
+        private:
+            std::string_view data_;
+            size_t pos_ = 0;
+            uint64_t buffer_ = 0;
+            uint32_t bits_ = 0;
+        };
+
+        // Названия по возрастанию: длина общего префикса с предыдущим, длина остатка и сам остаток.
+        // order - номер записи для каждого названия по порядку
+        void EncodeNames(const std::vector<std::string_view>& names, std::string& names_column, std::string& order_column) {
+            std::vector<uint32_t> order(names.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&names](uint32_t lhs, uint32_t rhs) {
+                return names[lhs] < names[rhs];
+            });
+
+            const uint32_t width = BitWidth(names.empty() ? 0 : names.size() - 1);
+            BitWriter order_writer;
+            std::string_view previous;
+
+            for (const uint32_t id : order) {
+                const std::string_view name = names[id];
+                const size_t prefix = std::mismatch(previous.begin(), previous.end(), name.begin(), name.end()).first - previous.begin();
+
+                PutVarint(names_column, prefix);
+                PutVarint(names_column, name.size() - prefix);
+                names_column.append(name.substr(prefix));
+                order_writer.Put(id, width);
+
+                previous = name;
+            }
+            order_column = order_writer.Finish();
+        }
+
+        std::vector<std::string> DecodeNames(std::string_view names_column, std::string_view order_column, size_t count) {
+            std::vector<std::string> names(count);
+            std::vector<bool> decoded(count, false);
+
+            const uint32_t width = BitWidth(count == 0 ? 0 : count - 1);
+            ColumnReader names_reader(names_column);
+            BitReader order_reader(order_column);
+            std::string previous;
+
+            for (size_t i = 0; i < count; ++i) {
+                const uint64_t prefix = names_reader.GetVarint();
+                if (prefix > previous.size()) {
+                    ThrowCorrupted();
+                }
+                previous.resize(prefix);
+                previous.append(names_reader.GetBytes(names_reader.GetVarint()));
+
+                const uint32_t id = order_reader.Get(width);
+                if (id >= count || decoded[id]) {
+                    ThrowCorrupted();
+                }
+                decoded[id] = true;
+                names[id] = previous;
+            }
+            return names;
+        }
+
+        // Следующее значение столбца разностей
+        int64_t GetDelta(ColumnReader& reader, int64_t& previous) {
+            previous += UnZigZag(reader.GetVarint());
+            return previous;
+        }
+
+        uint32_t GetStopId(ColumnReader& reader, int64_t& previous, size_t stop_count) {
+            const int64_t id = GetDelta(reader, previous);
+            if (id < 0 || static_cast<uint64_t>(id) >= stop_count) {
+                ThrowCorrupted();
+            }
+            return static_cast<uint32_t>(id);
+        }
+
+        int32_t GetCoordinate(ColumnReader& reader, int64_t& previous) {
+            const int64_t value = GetDelta(reader, previous);
+            if (value < INT32_MIN || value > INT32_MAX) {
+                ThrowCorrupted();
+            }
+            return static_cast<int32_t>(value);
+        }
+    }
+
+    transport_catalogue_protobuf::TransportCatalogue ColumnarCatalogueSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue) {
+
+        transport_catalogue_protobuf::TransportCatalogue transport_catalogue_proto;
+        auto& columnar = *transport_catalogue_proto.mutable_columnar();
+
+        const auto& stops = transport_catalogue.GetStops();
+        const auto& buses = transport_catalogue.GetBuses();
+        const auto& distances = transport_catalogue.GetDistance();
+
+        std::vector<std::string_view> stop_names;
+        std::vector<uint32_t> stop_regions;
+        std::unordered_map<std::string_view, uint32_t> region_to_id;
+
+        std::string latitudes;
+        std::string longitudes;
+        int64_t previous_lat = 0;
+        int64_t previous_lng = 0;
+
+        for (const auto& stop : stops) {
+            stop_names.push_back(stop.name_stop);
+
+            uint32_t region = 0;
+            if (!stop.region.empty()) {
+                auto [region_it, inserted] = region_to_id.insert({ stop.region, static_cast<uint32_t>(region_to_id.size() + 1) });
+                if (inserted) {
+                    transport_catalogue_proto.add_regions(stop.region);
+                }
+                region = region_it->second;
+            }
+            stop_regions.push_back(region);
+
+            const auto coordinates = transport_catalogue::detail::geo::EncodeCoordinates({ stop.latitude, stop.longitude });
+            PutVarint(latitudes, ZigZag(coordinates.lat - previous_lat));
+            PutVarint(longitudes, ZigZag(coordinates.lng - previous_lng));
+            previous_lat = coordinates.lat;
+            previous_lng = coordinates.lng;
+        }
+
+        EncodeNames(stop_names, *columnar.mutable_stop_names(), *columnar.mutable_stop_order());
+        columnar.set_latitudes(std::move(latitudes));
+        columnar.set_longitudes(std::move(longitudes));
+
+        const uint32_t region_width = BitWidth(region_to_id.size());
+        BitWriter regions_writer;
+        for (const uint32_t region : stop_regions) {
+            regions_writer.Put(region, region_width);
+        }
+        columnar.set_stop_regions(regions_writer.Finish());
+        columnar.set_stop_count(static_cast<uint32_t>(stops.size()));
+
+        std::vector<std::string_view> bus_names;
+        BitWriter flags_writer;
+        std::string stop_counts;
+        std::string bus_stops;
+
+        for (const auto& bus : buses) {
+            bus_names.push_back(bus.name_bus);
+
+            std::vector<uint32_t> ids;
+            for (const auto* stop : bus.stops_bus) {
+                ids.push_back(static_cast<uint32_t>(transport_catalogue.GetStopId(stop)));
+            }
+
+            // У некольцевого маршрута вторая половина - первая в обратном порядке
+            const bool mirrored = !bus.is_roundtrip && ids.size() % 2 == 1
+                && std::equal(ids.begin(), ids.begin() + ids.size() / 2, ids.rbegin());
+            const size_t stored = mirrored ? ids.size() / 2 + 1 : ids.size();
+
+            flags_writer.Put((bus.is_roundtrip ? COLUMNAR_BUS_ROUNDTRIP : 0) | (mirrored ? COLUMNAR_BUS_MIRRORED : 0), COLUMNAR_BUS_FLAGS_WIDTH);
+            PutVarint(stop_counts, stored);
+
+            int64_t previous = 0;
+            for (size_t i = 0; i < stored; ++i) {
+                PutVarint(bus_stops, ZigZag(static_cast<int64_t>(ids[i]) - previous));
+                previous = ids[i];
+            }
+        }
+
+        EncodeNames(bus_names, *columnar.mutable_bus_names(), *columnar.mutable_bus_order());
+        columnar.set_bus_flags(flags_writer.Finish());
+        columnar.set_bus_stop_counts(std::move(stop_counts));
+        columnar.set_bus_stops(std::move(bus_stops));
+        columnar.set_bus_count(static_cast<uint32_t>(buses.size()));
+
+        // Пары по возрастанию: начала идут неубывающими разностями, конец - относительно начала
+        std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> sorted_distances;
+        uint32_t max_distance = 0;
+
+        for (const auto& [pair_stops, pair_distance] : distances) {
+            const auto distance = static_cast<uint32_t>(pair_distance);
+            sorted_distances.emplace_back(static_cast<uint32_t>(transport_catalogue.GetStopId(pair_stops.first)),
+                static_cast<uint32_t>(transport_catalogue.GetStopId(pair_stops.second)), distance);
+            max_distance = std::max(max_distance, distance);
+        }
+        std::sort(sorted_distances.begin(), sorted_distances.end());
+
+        const uint32_t distance_width = BitWidth(max_distance);
+        std::string distance_starts;
+        std::string distance_ends;
+        BitWriter distances_writer;
+        uint32_t previous_start = 0;
+
+        for (const auto& [start, end, distance] : sorted_distances) {
+            PutVarint(distance_starts, start - previous_start);
+            PutVarint(distance_ends, ZigZag(static_cast<int64_t>(end) - start));
+            distances_writer.Put(distance, distance_width);
+            previous_start = start;
+        }
+
+        columnar.set_distance_starts(std::move(distance_starts));
+        columnar.set_distance_ends(std::move(distance_ends));
+        columnar.set_distances(distances_writer.Finish());
+        columnar.set_distance_width(distance_width);
+        columnar.set_distance_count(static_cast<uint32_t>(sorted_distances.size()));
+
+        transport_catalogue_proto.set_compact_coordinates(true);
+
+        return transport_catalogue_proto;
+    }
+
+    transport_catalogue::TransportCatalogue ColumnarCatalogueDeserialization(const transport_catalogue_protobuf::TransportCatalogue& transport_catalogue_proto) {
+
+        transport_catalogue::TransportCatalogue transport_catalogue;
+        const auto& columnar = transport_catalogue_proto.columnar();
+
+        const size_t stop_count = columnar.stop_count();
+        auto stop_names = DecodeNames(columnar.stop_names(), columnar.stop_order(), stop_count);
+
+        ColumnReader latitudes(columnar.latitudes());
+        ColumnReader longitudes(columnar.longitudes());
+        BitReader regions_reader(columnar.stop_regions());
+        const uint32_t region_width = BitWidth(transport_catalogue_proto.regions_size());
+        int64_t previous_lat = 0;
+        int64_t previous_lng = 0;
+
+        std::vector<transport_catalogue::Stop*> stops;
+        stops.reserve(stop_count);
+
+        for (auto& name : stop_names) {
+            transport_catalogue::Stop stop;
+
+            const auto coordinates = transport_catalogue::detail::geo::DecodeCoordinates({
+                GetCoordinate(latitudes, previous_lat), GetCoordinate(longitudes, previous_lng) });
+            stop.latitude = coordinates.lat;
+            stop.longitude = coordinates.lng;
+
+            const uint32_t region = regions_reader.Get(region_width);
+            if (region > static_cast<uint32_t>(transport_catalogue_proto.regions_size())) {
+                ThrowCorrupted();
+            }
+            if (region > 0) {
+                stop.region = transport_catalogue_proto.regions(region - 1);
+            }
+
+            stop.name_stop = std::move(name);
+            transport_catalogue.AddStop(std::move(stop));
+            stops.push_back(transport_catalogue.FindStop(transport_catalogue.GetStopById(stops.size())->name_stop));
+        }
+
+        ColumnReader distance_starts(columnar.distance_starts());
+        ColumnReader distance_ends(columnar.distance_ends());
+        BitReader distances_reader(columnar.distances());
+        if (columnar.distance_width() > 32) {
+            ThrowCorrupted();
+        }
+
+        std::vector<transport_catalogue::Distance> distances;
+        distances.reserve(columnar.distance_count());
+        uint64_t start = 0;
+
+        for (uint32_t i = 0; i < columnar.distance_count(); ++i) {
+            const uint64_t start_delta = distance_starts.GetVarint();
+            if (start_delta >= stop_count - start) {
+                ThrowCorrupted();
+            }
+            start += start_delta;
+
+            int64_t end = static_cast<int64_t>(start);
+            const uint32_t end_id = GetStopId(distance_ends, end, stop_count);
+
+            distances.push_back({ stops[start], stops[end_id], static_cast<int>(distances_reader.Get(columnar.distance_width())) });
+        }
+        transport_catalogue.AddDistance(distances);
+
+        const auto bus_names = DecodeNames(columnar.bus_names(), columnar.bus_order(), columnar.bus_count());
+        BitReader flags_reader(columnar.bus_flags());
+        ColumnReader stop_counts(columnar.bus_stop_counts());
+        ColumnReader bus_stops(columnar.bus_stops());
+
+        for (const auto& name : bus_names) {
+            transport_catalogue::Bus bus;
+
+            bus.name_bus = name;
+
+            const uint32_t flags = flags_reader.Get(COLUMNAR_BUS_FLAGS_WIDTH);
+            const uint64_t stored = stop_counts.GetVarint();
+            int64_t previous = 0;
+
+            for (uint64_t i = 0; i < stored; ++i) {
+                bus.stops_bus.push_back(stops[GetStopId(bus_stops, previous, stop_count)]);
+            }
+            if ((flags & COLUMNAR_BUS_MIRRORED) != 0) {
+                for (size_t i = bus.stops_bus.size(); i-- > 1;) {
+                    bus.stops_bus.push_back(bus.stops_bus[i - 1]);
+                }
+            }
+            bus.is_roundtrip = (flags & COLUMNAR_BUS_ROUNDTRIP) != 0;
+
+            transport_catalogue.AddBus(std::move(bus));
+        }
+
+        return transport_catalogue;
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_catalogue.pb.h"
+
+namespace serialization {
+
+    // Колоночное сжатое представление справочника (TransportCatalogue.columnar).
+    // Каждый столбец - отдельное поле bytes: координаты в фиксированной точке и номера остановок маршрутов
+    // записаны разностями соседних значений (zigzag varint), названия - по возрастанию с общими префиксами,
+    // расстояния и служебные номера - битовой упаковкой минимальной ширины.
+    // Номера остановок и порядок маршрутов сохраняются: на них ссылаются остальные секции базы
+    transport_catalogue_protobuf::TransportCatalogue ColumnarCatalogueSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue);
+    transport_catalogue::TransportCatalogue ColumnarCatalogueDeserialization(const transport_catalogue_protobuf::TransportCatalogue& transport_catalogue_proto);
+}
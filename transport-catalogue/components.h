@@ -0,0 +1,118 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Компоненты сильной связности (алгоритм Тарьяна без рекурсии).
+// Возвращает номер компоненты для каждой вершины
+template <typename Weight>
+std::vector<size_t> ComputeStrongComponents(const DirectedWeightedGraph<Weight>& graph) {
+    static constexpr size_t NO_INDEX = std::numeric_limits<size_t>::max();
+
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<size_t> index(vertex_count, NO_INDEX);
+    std::vector<size_t> low_link(vertex_count, 0);
+    std::vector<bool> on_stack(vertex_count, false);
+    std::vector<size_t> component(vertex_count, NO_INDEX);
+
+    std::vector<VertexId> stack;
+    std::vector<std::pair<VertexId, size_t>> call_stack;  // вершина и номер следующего исходящего ребра
+    size_t next_index = 0;
+    size_t next_component = 0;
+
+    for (VertexId root = 0; root < vertex_count; ++root) {
+        if (index[root] != NO_INDEX) {
+            continue;
+        }
+        call_stack.push_back({root, 0});
+
+        while (!call_stack.empty()) {
+            auto& [vertex, edge_pos] = call_stack.back();
+            if (edge_pos == 0 && index[vertex] == NO_INDEX) {
+                index[vertex] = low_link[vertex] = next_index++;
+                stack.push_back(vertex);
+                on_stack[vertex] = true;
+            }
+
+            const auto edges = graph.GetIncidentEdges(vertex);
+            const size_t edge_count = static_cast<size_t>(std::distance(edges.begin(), edges.end()));
+
+            if (edge_pos < edge_count) {
+                const VertexId next = graph.GetEdge(*(edges.begin() + edge_pos)).to;
+                ++edge_pos;
+                if (index[next] == NO_INDEX) {
+                    call_stack.push_back({next, 0});
+                } else if (on_stack[next]) {
+                    low_link[vertex] = std::min(low_link[vertex], index[next]);
+                }
+                continue;
+            }
+
+            const VertexId finished = vertex;
+            call_stack.pop_back();
+            if (!call_stack.empty()) {
+                const VertexId parent = call_stack.back().first;
+                low_link[parent] = std::min(low_link[parent], low_link[finished]);
+            }
+            if (low_link[finished] == index[finished]) {
+                VertexId member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member] = false;
+                    component[member] = next_component;
+                } while (member != finished);
+                ++next_component;
+            }
+        }
+    }
+    return component;
+}
+
+// Компоненты слабой связности - без учёта направления рёбер.
+// Вершины из разных компонент заведомо недостижимы друг из друга
+template <typename Weight>
+std::vector<size_t> ComputeWeakComponents(const DirectedWeightedGraph<Weight>& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<size_t> parent(vertex_count);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    auto find_root = [&parent](size_t vertex) {
+        while (parent[vertex] != vertex) {
+            parent[vertex] = parent[parent[vertex]];
+            vertex = parent[vertex];
+        }
+        return vertex;
+    };
+
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        const size_t from_root = find_root(edge.from);
+        const size_t to_root = find_root(edge.to);
+        if (from_root != to_root) {
+            parent[std::max(from_root, to_root)] = std::min(from_root, to_root);
+        }
+    }
+
+    // Номера компонент подряд в порядке первой вершины
+    std::vector<size_t> component(vertex_count);
+    std::vector<size_t> root_to_component(vertex_count, std::numeric_limits<size_t>::max());
+    size_t next_component = 0;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const size_t root = find_root(vertex);
+        if (root_to_component[root] == std::numeric_limits<size_t>::max()) {
+            root_to_component[root] = next_component++;
+        }
+        component[vertex] = root_to_component[root];
+    }
+    return component;
+}
+
+}  // namespace graph
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "graph.h"
+#include "radix_heap.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Дерево кратчайших путей от одной вершины (алгоритм Дейкстры).
+// Недостижимые вершины имеют вес UNREACHABLE и предыдущее ребро NO_EDGE
+template <typename Weight>
+struct ShortestPathTree {
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    VertexId source = 0;
+    std::vector<Weight> weights;
+    std::vector<EdgeId> prev_edges;
+
+    bool IsReachable(VertexId vertex) const {
+        return weights[vertex] != UNREACHABLE;
+    }
+
+    // Рёбра пути от source до вершины в порядке следования
+    std::vector<EdgeId> GetPathEdges(const DirectedWeightedGraph<Weight>& graph, VertexId to) const {
+        std::vector<EdgeId> edges;
+        VisitPathEdges(graph, to, [&edges](EdgeId edge_id) { edges.push_back(edge_id); });
+        return edges;
+    }
+
+    // То же без вектора рёбер: рёбра передаются visitor
+    template <typename Visitor>
+    void VisitPathEdges(const DirectedWeightedGraph<Weight>& graph, VertexId to, Visitor&& visitor) const {
+        VisitEdgeChain(prev_edges[to], NO_EDGE,
+                       [this, &graph](EdgeId edge_id) { return prev_edges[graph.GetEdge(edge_id).from]; },
+                       std::forward<Visitor>(visitor));
+    }
+};
+
+// Фильтр рёбер по умолчанию - разрешены все рёбра
+struct AllEdges {
+    bool operator()(EdgeId) const {
+        return true;
+    }
+};
+
+// Обычная двоичная куча для вещественных весов
+template <typename Weight>
+class BinaryHeap {
+public:
+    void Push(Weight weight, VertexId vertex) {
+        queue_.push({weight, vertex});
+    }
+
+    std::pair<Weight, VertexId> Pop() {
+        auto result = queue_.top();
+        queue_.pop();
+        return result;
+    }
+
+    bool IsEmpty() const {
+        return queue_.empty();
+    }
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue_;
+};
+
+// Для целых беззнаковых весов очередь монотонная (radix heap), для остальных - двоичная куча
+template <typename Weight>
+using DijkstraQueue = std::conditional_t<std::is_unsigned_v<Weight>, RadixHeap<Weight, VertexId>, BinaryHeap<Weight>>;
+
+// Монотонная очередь для вещественных весов: ключ radix heap - вес в долях 1/scale, округлённый вниз.
+// Ключ не убывает вместе с весом, а элементы одного ключа извлекаются по точному весу и номеру вершины,
+// поэтому порядок извлечения и деревья путей те же, что у двоичной кучи по точным весам
+template <typename Weight>
+class QuantizedHeap {
+public:
+    explicit QuantizedHeap(double scale)
+        : scale_(scale) {
+    }
+
+    void Push(Weight weight, VertexId vertex) {
+        const uint64_t key = GetKey(weight);
+        if (!current_.IsEmpty() && key == current_key_) {
+            current_.Push(weight, vertex);
+        } else {
+            buckets_.Push(key, {weight, vertex});
+        }
+    }
+
+    std::pair<Weight, VertexId> Pop() {
+        if (!current_.IsEmpty()) {
+            return current_.Pop();
+        }
+
+        current_key_ = buckets_.PopMinKey(same_key_);
+        // Обычно у ключа один элемент - он и есть минимум, куча не нужна
+        if (same_key_.size() == 1) {
+            const auto item = same_key_.front().second;
+            same_key_.clear();
+            return item;
+        }
+        for (const auto& [_, item] : same_key_) {
+            current_.Push(item.first, item.second);
+        }
+        same_key_.clear();
+        return current_.Pop();
+    }
+
+    bool IsEmpty() const {
+        return current_.IsEmpty() && buckets_.IsEmpty();
+    }
+
+private:
+    uint64_t GetKey(Weight weight) const {
+        return static_cast<uint64_t>(weight * scale_);
+    }
+
+    double scale_;
+    RadixHeap<uint64_t, std::pair<Weight, VertexId>> buckets_;
+    BinaryHeap<Weight> current_;                                           // элементы ключа current_key_
+    uint64_t current_key_ = 0;
+    std::vector<std::pair<uint64_t, std::pair<Weight, VertexId>>> same_key_;
+};
+
+// Общий цикл поиска от нескольких источников с начальными весами: путь до вершины начинается в том источнике,
+// откуда он короче. stop_at(vertex) вызывается для каждой вершины в момент, когда путь до неё окончателен,
+// и true останавливает поиск. source дерева - первый источник. queue - очередь с приоритетом, пустая
+template <typename Weight, typename EdgeFilter, typename StopCondition, typename Queue = DijkstraQueue<Weight>>
+ShortestPathTree<Weight> RunDijkstra(const DirectedWeightedGraph<Weight>& graph,
+                                     const std::vector<std::pair<VertexId, Weight>>& sources,
+                                     std::optional<Weight> max_weight, EdgeFilter edge_filter, StopCondition&& stop_at,
+                                     Queue queue = {}) {
+    using Tree = ShortestPathTree<Weight>;
+
+    static constexpr Weight ZERO_WEIGHT{};
+
+    Tree tree;
+    tree.source = sources.empty() ? 0 : sources.front().first;
+    tree.weights.assign(graph.GetVertexCount(), Tree::UNREACHABLE);
+    tree.prev_edges.assign(graph.GetVertexCount(), Tree::NO_EDGE);
+
+    for (const auto& [source, weight] : sources) {
+        if (weight < tree.weights.at(source)) {
+            tree.weights[source] = weight;
+            queue.Push(weight, source);
+        }
+    }
+
+    while (!queue.IsEmpty()) {
+        const auto [weight, vertex] = queue.Pop();
+        if (weight > tree.weights[vertex]) {
+            continue;
+        }
+        if (stop_at(vertex)) {
+            break;
+        }
+
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            if (!edge_filter(edge_id)) {
+                continue;
+            }
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            if (max_weight && candidate_weight > *max_weight) {
+                continue;
+            }
+            if (candidate_weight < tree.weights[edge.to]) {
+                tree.weights[edge.to] = candidate_weight;
+                tree.prev_edges[edge.to] = edge_id;
+                queue.Push(candidate_weight, edge.to);
+            }
+        }
+    }
+    return tree;
+}
+
+template <typename Weight, typename EdgeFilter, typename StopCondition, typename Queue = DijkstraQueue<Weight>>
+ShortestPathTree<Weight> RunDijkstra(const DirectedWeightedGraph<Weight>& graph, VertexId source,
+                                     std::optional<Weight> max_weight, EdgeFilter edge_filter, StopCondition&& stop_at,
+                                     Queue queue = {}) {
+    return RunDijkstra(graph, std::vector<std::pair<VertexId, Weight>>{{source, Weight{}}}, max_weight, edge_filter,
+                       std::forward<StopCondition>(stop_at), std::move(queue));
+}
+
+// max_weight ограничивает поиск: вершины дальше него остаются недостижимыми, а поиск завершается раньше.
+// target останавливает поиск, как только до неё найден кратчайший путь; веса прочих вершин тогда могут быть неокончательными.
+// edge_filter(edge_id) решает, можно ли использовать ребро
+template <typename Weight, typename EdgeFilter = AllEdges, typename Queue = DijkstraQueue<Weight>>
+ShortestPathTree<Weight> BuildShortestPathTree(const DirectedWeightedGraph<Weight>& graph, VertexId source,
+                                               std::optional<Weight> max_weight = std::nullopt,
+                                               std::optional<VertexId> target = std::nullopt,
+                                               EdgeFilter edge_filter = {}, Queue queue = {}) {
+    return RunDijkstra(graph, source, max_weight, edge_filter, [&target](VertexId vertex) {
+        return target && vertex == *target;
+    }, std::move(queue));
+}
+
+// Поиск "от одного (или нескольких) ко многим": останавливается, как только найдены кратчайшие пути до всех targets,
+// то есть просматривает вершины не дальше самой дальней цели. Окончательны веса только целей
+template <typename Weight>
+ShortestPathTree<Weight> BuildShortestPathTreeToTargets(const DirectedWeightedGraph<Weight>& graph,
+                                                        const std::vector<std::pair<VertexId, Weight>>& sources,
+                                                        const std::vector<VertexId>& targets,
+                                                        std::optional<Weight> max_weight = std::nullopt) {
+    std::vector<bool> is_target(graph.GetVertexCount(), false);
+    size_t remaining = 0;
+
+    for (const VertexId target : targets) {
+        if (!is_target.at(target)) {
+            is_target[target] = true;
+            ++remaining;
+        }
+    }
+
+    return RunDijkstra(graph, sources, max_weight, AllEdges{}, [&is_target, &remaining](VertexId vertex) {
+        if (is_target[vertex]) {
+            is_target[vertex] = false;
+            --remaining;
+        }
+        return remaining == 0;
+    });
+}
+
+template <typename Weight>
+ShortestPathTree<Weight> BuildShortestPathTreeToTargets(const DirectedWeightedGraph<Weight>& graph, VertexId source,
+                                                        const std::vector<VertexId>& targets) {
+    return BuildShortestPathTreeToTargets(graph, std::vector<std::pair<VertexId, Weight>>{{source, Weight{}}}, targets);
+}
+
+}  // namespace graph
@@ -13,6 +13,16 @@ namespace transport_catalogue {
             std::string name;
             std::string from;
             std::string to;
+            geo::Coordinates coordinates;       // точка запроса NearestStops
+            int count = 1;                      // количество ближайших остановок
+            geo::Coordinates min_coordinates;   // нижний левый угол StopsInBBox
+            geo::Coordinates max_coordinates;   // верхний правый угол StopsInBBox
+            std::vector<std::string> from_stops;  // начальные остановки RouteMatrix
+            std::vector<std::string> to_stops;    // конечные остановки RouteMatrix
+            double max_time = 0.0;                // ограничение времени Isochrone, в минутах
+            int alternatives = 1;                 // сколько маршрутов вернуть на запрос Route
+            std::string profile;                  // профиль маршрутизации для Route и Isochrone, пустой - основные настройки
+            bool itinerary = true;                // false - в ответе на Route только total_time, без участков
         };
 
         struct BusQuery {
@@ -29,5 +39,13 @@ namespace transport_catalogue {
             bool not_found;
             std::vector <std::string> buses_name;
         };
+
+        struct NearestStopsQuery {
+            std::vector<std::pair<std::string_view, double>> stops;    // название остановки и расстояние до неё
+        };
+
+        struct StopsInBBoxQuery {
+            std::vector<std::string_view> stops;
+        };
     }
 }//end namespace transport_catalogue
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include "flat_base.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace serialization {
+
+    namespace {
+        // Секции выравниваются, чтобы записи можно было читать прямо из отображения
+        const uint64_t FLAT_ALIGNMENT = 8;
+
+        static_assert(std::is_trivially_copyable_v<FlatHeader> && std::is_trivially_copyable_v<FlatStop>
+            && std::is_trivially_copyable_v<FlatBus> && std::is_trivially_copyable_v<FlatDistance>);
+        static_assert(alignof(FlatStop) <= FLAT_ALIGNMENT && alignof(FlatBus) <= FLAT_ALIGNMENT);
+
+        uint64_t AlignUp(uint64_t offset) {
+            return (offset + FLAT_ALIGNMENT - 1) / FLAT_ALIGNMENT * FLAT_ALIGNMENT;
+        }
+
+        FlatName AppendName(std::string& names, std::string_view name) {
+            if (names.size() + name.size() > UINT32_MAX) {
+                throw std::length_error("flat base names exceed 4 GB");
+            }
+
+            const FlatName result{ static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size()) };
+            names.append(name);
+            return result;
+        }
+
+        template <typename T>
+        std::string_view AsBytes(const std::vector<T>& records) {
+            return { reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T) };
+        }
+
+        // Номера записей, упорядоченные по названию
+        template <typename Record>
+        std::vector<uint32_t> SortByName(const std::vector<Record>& records, std::string_view names) {
+            std::vector<uint32_t> ids(records.size());
+            std::iota(ids.begin(), ids.end(), 0);
+
+            std::sort(ids.begin(), ids.end(), [&records, names](uint32_t lhs, uint32_t rhs) {
+                return names.substr(records[lhs].name.offset, records[lhs].name.size) < names.substr(records[rhs].name.offset, records[rhs].name.size);
+            });
+            return ids;
+        }
+    }
+
+    void FlatBaseSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue,
+        const transport_catalogue_protobuf::Catalogue& sections_proto,
+        std::ostream& out) {
+
+        std::string names;
+        std::vector<FlatStop> stops;
+        std::vector<uint32_t> stop_buses;
+        std::vector<FlatBus> buses;
+        std::vector<uint32_t> bus_stops;
+        std::vector<FlatDistance> distances;
+
+        // Номер маршрута - порядок добавления в справочник
+        const auto tc_buses = transport_catalogue.GetBuses();
+        std::unordered_map<std::string_view, uint32_t> bus_to_id;
+        for (const auto& bus : tc_buses) {
+            bus_to_id.insert({ bus.name_bus, static_cast<uint32_t>(bus_to_id.size()) });
+        }
+
+        // Маршруты остановки хранятся уже в том виде, в каком их отдаёт запрос Stop
+        for (size_t id = 0; const transport_catalogue::Stop* stop = transport_catalogue.GetStopById(id); ++id) {
+            std::vector<uint32_t> ids;
+            for (const auto* bus : stop->buses_vector) {
+                ids.push_back(bus_to_id.at(bus->name_bus));
+            }
+
+            std::sort(ids.begin(), ids.end(), [&tc_buses](uint32_t lhs, uint32_t rhs) {
+                return tc_buses[lhs].name_bus < tc_buses[rhs].name_bus;
+            });
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+            stops.push_back({ AppendName(names, stop->name_stop), AppendName(names, stop->region),
+                              static_cast<uint32_t>(stop_buses.size()), static_cast<uint32_t>(ids.size()),
+                              stop->latitude, stop->longitude });
+            stop_buses.insert(stop_buses.end(), ids.begin(), ids.end());
+        }
+
+        for (const auto& bus : tc_buses) {
+            const size_t stops_begin = bus_stops.size();
+            for (const auto* stop : bus.stops_bus) {
+                bus_stops.push_back(static_cast<uint32_t>(transport_catalogue.GetStopId(stop)));
+            }
+
+            std::vector<uint32_t> unique_stops(bus_stops.begin() + stops_begin, bus_stops.end());
+            std::sort(unique_stops.begin(), unique_stops.end());
+            unique_stops.erase(std::unique(unique_stops.begin(), unique_stops.end()), unique_stops.end());
+
+            buses.push_back({ AppendName(names, bus.name_bus), static_cast<uint32_t>(stops_begin), static_cast<uint32_t>(bus.stops_bus.size()),
+                              static_cast<uint32_t>(unique_stops.size()), bus.is_roundtrip ? 1u : 0u, bus.route_length, bus.geo_length });
+        }
+
+        for (const auto& [pair_stops, pair_distance] : transport_catalogue.GetDistance()) {
+            distances.push_back({ static_cast<uint32_t>(transport_catalogue.GetStopId(pair_stops.first)),
+                                  static_cast<uint32_t>(transport_catalogue.GetStopId(pair_stops.second)),
+                                  static_cast<uint32_t>(pair_distance) });
+        }
+        std::sort(distances.begin(), distances.end(), [](const FlatDistance& lhs, const FlatDistance& rhs) {
+            return std::make_pair(lhs.start, lhs.end) < std::make_pair(rhs.start, rhs.end);
+        });
+
+        const std::vector<uint32_t> stop_names = SortByName(stops, names);
+        const std::vector<uint32_t> bus_names = SortByName(buses, names);
+        const std::string sections_data = sections_proto.SerializeAsString();
+
+        // Порядок совпадает с FlatSectionId
+        const std::array<std::string_view, static_cast<size_t>(FlatSectionId::COUNT)> sections = {
+            names, AsBytes(stops), AsBytes(stop_buses), AsBytes(buses), AsBytes(bus_stops),
+            AsBytes(distances), AsBytes(stop_names), AsBytes(bus_names), sections_data
+        };
+
+        FlatHeader header{ FLAT_BASE_MAGIC, FLAT_BASE_VERSION, static_cast<uint32_t>(FlatSectionId::COUNT), 0, {} };
+        uint64_t offset = AlignUp(sizeof(FlatHeader));
+
+        for (size_t i = 0; i < sections.size(); ++i) {
+            header.sections[i] = { offset, sections[i].size() };
+            offset = AlignUp(offset + sections[i].size());
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        uint64_t written = sizeof(header);
+
+        const char padding[FLAT_ALIGNMENT] = {};
+        for (size_t i = 0; i < sections.size(); ++i) {
+            out.write(padding, header.sections[i].offset - written);
+            out.write(sections[i].data(), sections[i].size());
+            written = header.sections[i].offset + sections[i].size();
+        }
+    }
+
+    FlatBase::FlatBase(const std::string& file_name) {
+        const int fd = open(file_name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open flat base " + file_name);
+        }
+
+        struct stat file_stat {};
+        if (fstat(fd, &file_stat) != 0 || static_cast<uint64_t>(file_stat.st_size) < sizeof(FlatHeader)) {
+            close(fd);
+            throw std::runtime_error("flat base is corrupted");
+        }
+
+        size_ = static_cast<size_t>(file_stat.st_size);
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("cannot map flat base " + file_name);
+        }
+        data_ = static_cast<const char*>(data);
+
+        // Запросы читают базу вразброс: упреждающее чтение соседних страниц только мешает
+        madvise(data, size_, MADV_RANDOM);
+
+        FlatHeader header;
+        std::memcpy(&header, data_, sizeof(header));
+
+        bool valid = header.magic == FLAT_BASE_MAGIC && header.version == FLAT_BASE_VERSION
+            && header.section_count == static_cast<uint32_t>(FlatSectionId::COUNT);
+
+        for (size_t i = 0; valid && i < sections_.size(); ++i) {
+            const FlatSection& section = header.sections[i];
+
+            valid = section.offset % FLAT_ALIGNMENT == 0 && section.offset <= size_ && section.size <= size_ - section.offset;
+            sections_[i] = { data_ + section.offset, static_cast<size_t>(section.size) };
+        }
+
+        if (!valid) {
+            munmap(data, size_);
+            throw std::runtime_error("flat base is corrupted or has unsupported version");
+        }
+    }
+
+    FlatBase::~FlatBase() {
+        munmap(const_cast<char*>(data_), size_);
+    }
+
+    bool FlatBase::IsFlatBase(const std::string& file_name) {
+        std::ifstream in(file_name, std::ios::binary);
+        std::array<char, 4> magic{};
+
+        in.read(magic.data(), magic.size());
+        return in && magic == FLAT_BASE_MAGIC;
+    }
+
+    template <typename T>
+    ranges::Range<const T*> FlatBase::GetSection(FlatSectionId id) const {
+        const std::string_view section = sections_[static_cast<size_t>(id)];
+        const T* begin = reinterpret_cast<const T*>(section.data());
+
+        return { begin, begin + section.size() / sizeof(T) };
+    }
+
+    template <typename T>
+    const T& FlatBase::GetRecord(FlatSectionId id, uint32_t index) const {
+        const auto records = GetSection<T>(id);
+
+        if (index >= static_cast<size_t>(records.end() - records.begin())) {
+            throw std::out_of_range("flat base record is out of range");
+        }
+        return records.begin()[index];
+    }
+
+    // Двоичный поиск по отсортированному индексу: затрагивает O(log n) записей и названий
+    template <typename Record>
+    std::optional<uint32_t> FlatBase::FindByName(FlatSectionId index_id, FlatSectionId records_id, std::string_view name) const {
+        const auto index = GetSection<uint32_t>(index_id);
+
+        const auto it = std::lower_bound(index.begin(), index.end(), name, [this, records_id](uint32_t id, std::string_view value) {
+            return GetName(GetRecord<Record>(records_id, id).name) < value;
+        });
+
+        if (it == index.end() || GetName(GetRecord<Record>(records_id, *it).name) != name) {
+            return std::nullopt;
+        }
+        return *it;
+    }
+
+    std::optional<uint32_t> FlatBase::FindStop(std::string_view name) const {
+        return FindByName<FlatStop>(FlatSectionId::STOP_NAMES, FlatSectionId::STOPS, name);
+    }
+
+    std::optional<uint32_t> FlatBase::FindBus(std::string_view name) const {
+        return FindByName<FlatBus>(FlatSectionId::BUS_NAMES, FlatSectionId::BUSES, name);
+    }
+
+    const FlatStop& FlatBase::GetStop(uint32_t id) const {
+        return GetRecord<FlatStop>(FlatSectionId::STOPS, id);
+    }
+
+    const FlatBus& FlatBase::GetBus(uint32_t id) const {
+        return GetRecord<FlatBus>(FlatSectionId::BUSES, id);
+    }
+
+    std::string_view FlatBase::GetName(FlatName name) const {
+        const std::string_view names = sections_[static_cast<size_t>(FlatSectionId::NAMES)];
+
+        if (name.offset > names.size() || name.size > names.size() - name.offset) {
+            throw std::out_of_range("flat base name is out of range");
+        }
+        return names.substr(name.offset, name.size);
+    }
+
+    ranges::Range<const uint32_t*> FlatBase::GetStopBuses(const FlatStop& stop) const {
+        return GetIds(FlatSectionId::STOP_BUSES, stop.buses_begin, stop.buses_count);
+    }
+
+    ranges::Range<const uint32_t*> FlatBase::GetBusStops(const FlatBus& bus) const {
+        return GetIds(FlatSectionId::BUS_STOPS, bus.stops_begin, bus.stops_count);
+    }
+
+    // Справочник собирается из массивов без разбора protobuf, protobuf остаётся только у настроек и предрасчётов
+    Catalogue FlatBase::LoadCatalogue() const {
+        madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+
+        transport_catalogue::TransportCatalogue transport_catalogue;
+        std::vector<transport_catalogue::Stop*> stops;
+
+        for (const FlatStop& flat_stop : GetSection<FlatStop>(FlatSectionId::STOPS)) {
+            transport_catalogue::Stop stop;
+
+            stop.name_stop = GetName(flat_stop.name);
+            stop.region = GetName(flat_stop.region);
+            stop.latitude = flat_stop.latitude;
+            stop.longitude = flat_stop.longitude;
+
+            transport_catalogue.AddStop(std::move(stop));
+            stops.push_back(transport_catalogue.FindStop(GetName(flat_stop.name)));
+        }
+
+        std::vector<transport_catalogue::Distance> distances;
+        for (const FlatDistance& distance : GetSection<FlatDistance>(FlatSectionId::DISTANCES)) {
+            distances.push_back({ stops.at(distance.start), stops.at(distance.end), static_cast<int>(distance.distance) });
+        }
+        transport_catalogue.AddDistance(distances);
+
+        for (const FlatBus& flat_bus : GetSection<FlatBus>(FlatSectionId::BUSES)) {
+            transport_catalogue::Bus bus;
+
+            bus.name_bus = GetName(flat_bus.name);
+            for (const uint32_t stop_id : GetBusStops(flat_bus)) {
+                bus.stops_bus.push_back(stops.at(stop_id));
+            }
+            bus.is_roundtrip = flat_bus.is_roundtrip != 0;
+            bus.route_length = flat_bus.route_length;
+
+            transport_catalogue.AddBus(std::move(bus));
+        }
+
+        const std::string_view sections_data = sections_[static_cast<size_t>(FlatSectionId::SECTIONS)];
+        transport_catalogue_protobuf::Catalogue catalogue_proto;
+
+        if (!catalogue_proto.ParseFromArray(sections_data.data(), static_cast<int>(sections_data.size()))) {
+            throw std::runtime_error("cannot parse flat base sections");
+        }
+
+        return CatalogueSectionsDeserialization(catalogue_proto, std::move(transport_catalogue));
+    }
+
+    ranges::Range<const uint32_t*> FlatBase::GetIds(FlatSectionId id, uint32_t begin, uint32_t count) const {
+        const auto ids = GetSection<uint32_t>(id);
+
+        if (begin > static_cast<size_t>(ids.end() - ids.begin()) || count > static_cast<size_t>(ids.end() - ids.begin()) - begin) {
+            throw std::out_of_range("flat base ids are out of range");
+        }
+        return { ids.begin() + begin, ids.begin() + begin + count };
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "serialization.h"
+#include "ranges.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace serialization {
+
+    // Плоский формат базы: заголовок с таблицей секций и массивы записей фиксированного размера,
+    // ссылки между записями - номера и смещения, а не указатели. Файл отображается в память и читается на месте:
+    // запуск стоит столько страниц, сколько затронули запросы, а не весь размер базы.
+    // Числа записаны в порядке байт машины, собравшей базу
+
+    const std::array<char, 4> FLAT_BASE_MAGIC = { 'T', 'C', 'F', 'B' };
+    const uint32_t FLAT_BASE_VERSION = 1;
+
+    enum class FlatSectionId : uint32_t {
+        NAMES,          // названия остановок, маршрутов и регионов подряд, без разделителей
+        STOPS,          // FlatStop по номеру остановки
+        STOP_BUSES,     // номера маршрутов каждой остановки без повторов, по возрастанию названия
+        BUSES,          // FlatBus в порядке добавления
+        BUS_STOPS,      // номера остановок маршрутов, у некольцевых - вместе с обратным ходом
+        DISTANCES,      // FlatDistance по возрастанию пары остановок
+        STOP_NAMES,     // номера остановок по возрастанию названия - для поиска по имени
+        BUS_NAMES,      // номера маршрутов по возрастанию названия
+        SECTIONS,       // protobuf Catalogue без справочника: настройки и предрасчёты маршрутизации
+        COUNT
+    };
+
+    struct FlatSection {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct FlatHeader {
+        std::array<char, 4> magic;
+        uint32_t version;
+        uint32_t section_count;
+        uint32_t reserved;
+        std::array<FlatSection, static_cast<size_t>(FlatSectionId::COUNT)> sections;
+    };
+
+    // Строка в секции NAMES
+    struct FlatName {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct FlatStop {
+        FlatName name;
+        FlatName region;
+        uint32_t buses_begin;       // диапазон в STOP_BUSES
+        uint32_t buses_count;
+        double latitude;
+        double longitude;
+    };
+
+    struct FlatBus {
+        FlatName name;
+        uint32_t stops_begin;       // диапазон в BUS_STOPS
+        uint32_t stops_count;
+        uint32_t unique_stops;
+        uint32_t is_roundtrip;
+        uint64_t route_length;
+        double geo_length;
+    };
+
+    struct FlatDistance {
+        uint32_t start;
+        uint32_t end;
+        uint32_t distance;
+    };
+
+    void FlatBaseSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue,
+        const transport_catalogue_protobuf::Catalogue& sections_proto,
+        std::ostream& out);
+
+    // Отображённая в память плоская база. Конструктор проверяет только заголовок и границы секций,
+    // записи читаются по мере обращения
+    class FlatBase {
+    public:
+        explicit FlatBase(const std::string& file_name);
+        ~FlatBase();
+
+        FlatBase(const FlatBase&) = delete;
+        FlatBase& operator=(const FlatBase&) = delete;
+
+        static bool IsFlatBase(const std::string& file_name);
+
+        std::optional<uint32_t> FindStop(std::string_view name) const;
+        std::optional<uint32_t> FindBus(std::string_view name) const;
+
+        const FlatStop& GetStop(uint32_t id) const;
+        const FlatBus& GetBus(uint32_t id) const;
+        std::string_view GetName(FlatName name) const;
+        ranges::Range<const uint32_t*> GetStopBuses(const FlatStop& stop) const;
+        ranges::Range<const uint32_t*> GetBusStops(const FlatBus& bus) const;
+
+        // Полная загрузка - для запросов, которым нужны справочник и маршрутизатор
+        Catalogue LoadCatalogue() const;
+
+    private:
+        template <typename T>
+        ranges::Range<const T*> GetSection(FlatSectionId id) const;
+
+        template <typename T>
+        const T& GetRecord(FlatSectionId id, uint32_t index) const;
+
+        template <typename Record>
+        std::optional<uint32_t> FindByName(FlatSectionId index_id, FlatSectionId records_id, std::string_view name) const;
+
+        ranges::Range<const uint32_t*> GetIds(FlatSectionId id, uint32_t begin, uint32_t count) const;
+
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        std::array<std::string_view, static_cast<size_t>(FlatSectionId::COUNT)> sections_;
+    };
+}
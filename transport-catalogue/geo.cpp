@@ -1,22 +1,244 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace transport_catalogue {
     namespace detail {
         namespace geo {
 
+            static const double dr = NUMBER_PI / 180.;
+
+            namespace {
+                // Ряд Тейлора косинуса до x^10, для |x| <= pi / 2 ошибка не больше x^12 / 12!
+                double PolynomialCos(double x) {
+                    const double x2 = x * x;
+                    return 1.0 - x2 / 2.0 * (1.0 - x2 / 12.0 * (1.0 - x2 / 30.0 * (1.0 - x2 / 56.0 * (1.0 - x2 / 90.0))));
+                }
+
+                double LongitudeDelta(double from_lng, double to_lng) {
+                    const double delta = std::abs(from_lng - to_lng);
+                    return delta > 180.0 ? 360.0 - delta : delta;
+                }
+
+                double Haversine(double from_lat, double to_lat, double lng_delta, double from_cos_lat, double to_cos_lat) {
+                    const double sin_lat = std::sin((to_lat - from_lat) * dr / 2.0);
+                    const double sin_lng = std::sin(lng_delta * dr / 2.0);
+                    const double h = sin_lat * sin_lat + from_cos_lat * to_cos_lat * sin_lng * sin_lng;
+
+                    return 2.0 * std::asin(std::min(1.0, std::sqrt(h))) * RADIUS_EARTH;
+                }
+
+                double Equirectangular(double from_lat, double to_lat, double lng_delta, double cos_mean_lat) {
+                    const double x = lng_delta * dr * cos_mean_lat;
+                    const double y = (to_lat - from_lat) * dr;
+
+                    return std::sqrt(x * x + y * y) * RADIUS_EARTH;
+                }
+
+                // cos средней широты по закэшированным sin/cos концов: cos^2(x / 2) = (1 + cos x) / 2,
+                // cos(a + b) = cos a cos b - sin a sin b. Средняя широта в [-90, 90], поэтому косинус неотрицателен
+                double MeanLatitudeCos(const TrigCoordinates& from, const TrigCoordinates& to) {
+                    return std::sqrt(std::max(0.0, (1.0 + from.cos_lat * to.cos_lat - from.sin_lat * to.sin_lat) / 2.0));
+                }
+
+                double SequenceHop(const TrigSequence& sequence, size_t to, DistanceModel model) {
+                    const double from_lat = sequence.lat[to - 1];
+                    const double to_lat = sequence.lat[to];
+                    const double lng_delta = LongitudeDelta(sequence.lng[to - 1], sequence.lng[to]);
+
+                    if (model == DistanceModel::POLYNOMIAL) {
+                        return Equirectangular(from_lat, to_lat, lng_delta, PolynomialCos((from_lat + to_lat) / 2.0 * dr));
+                    }
+                    return Equirectangular(from_lat, to_lat, lng_delta, MeanLatitudeCos(sequence.At(to - 1), sequence.At(to)));
+                }
+
+#ifdef __SSE2__
+                __m128d PolynomialCos(__m128d x) {
+                    const __m128d one = _mm_set1_pd(1.0);
+                    const __m128d x2 = _mm_mul_pd(x, x);
+
+                    __m128d result = _mm_sub_pd(one, _mm_div_pd(x2, _mm_set1_pd(90.0)));
+                    for (double divisor : { 56.0, 30.0, 12.0, 2.0 }) {
+                        result = _mm_sub_pd(one, _mm_mul_pd(_mm_div_pd(x2, _mm_set1_pd(divisor)), result));
+                    }
+                    return result;
+                }
+
+                // Две соседние пары (to - 1, to) и (to, to + 1) за шаг, формулы те же, что в SequenceHop
+                __m128d SequenceHops(const TrigSequence& sequence, size_t to, DistanceModel model) {
+                    const __m128d from_lat = _mm_loadu_pd(&sequence.lat[to - 1]);
+                    const __m128d to_lat = _mm_loadu_pd(&sequence.lat[to]);
+                    const __m128d sign_mask = _mm_set1_pd(-0.0);
+                    const __m128d radians = _mm_set1_pd(dr);
+
+                    __m128d lng_delta = _mm_andnot_pd(sign_mask, _mm_sub_pd(_mm_loadu_pd(&sequence.lng[to - 1]), _mm_loadu_pd(&sequence.lng[to])));
+                    lng_delta = _mm_min_pd(lng_delta, _mm_sub_pd(_mm_set1_pd(360.0), lng_delta));
+
+                    __m128d cos_mean_lat;
+                    if (model == DistanceModel::POLYNOMIAL) {
+                        cos_mean_lat = PolynomialCos(_mm_mul_pd(_mm_div_pd(_mm_add_pd(from_lat, to_lat), _mm_set1_pd(2.0)), radians));
+                    }
+                    else {
+                        const __m128d cos_product = _mm_mul_pd(_mm_loadu_pd(&sequence.cos_lat[to - 1]), _mm_loadu_pd(&sequence.cos_lat[to]));
+                        const __m128d sin_product = _mm_mul_pd(_mm_loadu_pd(&sequence.sin_lat[to - 1]), _mm_loadu_pd(&sequence.sin_lat[to]));
+                        const __m128d half = _mm_div_pd(_mm_sub_pd(_mm_add_pd(_mm_set1_pd(1.0), cos_product), sin_product), _mm_set1_pd(2.0));
+                        cos_mean_lat = _mm_sqrt_pd(_mm_max_pd(_mm_setzero_pd(), half));
+                    }
+
+                    const __m128d x = _mm_mul_pd(_mm_mul_pd(lng_delta, radians), cos_mean_lat);
+                    const __m128d y = _mm_mul_pd(_mm_sub_pd(to_lat, from_lat), radians);
+
+                    return _mm_mul_pd(_mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y))), _mm_set1_pd(RADIUS_EARTH));
+                }
+#endif
+            }
+
+            CompactCoordinates EncodeCoordinates(Coordinates coordinates) {
+                return { static_cast<int32_t>(std::llround(coordinates.lat * COORDINATE_SCALE)),
+                         static_cast<int32_t>(std::llround(coordinates.lng * COORDINATE_SCALE)) };
+            }
+
+            Coordinates DecodeCoordinates(CompactCoordinates coordinates) {
+                return { coordinates.lat / COORDINATE_SCALE, coordinates.lng / COORDINATE_SCALE };
+            }
+
             double ComputeDistance(Coordinates from, Coordinates to) {
                 using namespace std;
                 if (from == to) {
                     return 0;
                 }
-                static const double dr = NUMBER_PI / 180.;
                 return acos(sin(from.lat * dr) * sin(to.lat * dr)
                     + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
                     * RADIUS_EARTH;
             }
+
+            double ComputeDistance(Coordinates from, Coordinates to, DistanceModel model) {
+                const double lng_delta = LongitudeDelta(from.lng, to.lng);
+
+                switch (model) {
+                case DistanceModel::HAVERSINE:
+                    return Haversine(from.lat, to.lat, lng_delta, std::cos(from.lat * dr), std::cos(to.lat * dr));
+                case DistanceModel::EQUIRECTANGULAR:
+                    return Equirectangular(from.lat, to.lat, lng_delta, std::cos((from.lat + to.lat) / 2.0 * dr));
+                case DistanceModel::POLYNOMIAL:
+                    return Equirectangular(from.lat, to.lat, lng_delta, PolynomialCos((from.lat + to.lat) / 2.0 * dr));
+                default:
+                    return ComputeDistance(from, to);
+                }
+            }
+
+            double GetDistanceErrorBound(DistanceModel model, double max_distance, double max_latitude) {
+                const double latitude = std::min(std::abs(max_latitude), 90.0) * dr;
+                const double cos_lat = std::cos(latitude);
+                const double angle = max_distance / RADIUS_EARTH;
+                const double rounding = max_distance * 1e-12;
+
+                switch (model) {
+                case DistanceModel::SPHERICAL_COSINES:
+                    return RADIUS_EARTH * std::sqrt(4.0 * std::numeric_limits<double>::epsilon()) + rounding;
+                case DistanceModel::HAVERSINE:
+                    return rounding;
+                case DistanceModel::EQUIRECTANGULAR:
+                    return max_distance * angle * angle / (8.0 * cos_lat * cos_lat) + rounding;
+                case DistanceModel::POLYNOMIAL:
+                    return max_distance * (angle * angle / (8.0 * cos_lat * cos_lat) + std::pow(latitude, 12) / 479001600.0 / cos_lat) + rounding;
+                }
+                return 0.0;
+            }
+
+            DistanceModel SelectDistanceModel(double max_distance, double max_latitude, double tolerance) {
+                for (DistanceModel model : { DistanceModel::POLYNOMIAL, DistanceModel::EQUIRECTANGULAR }) {
+                    if (GetDistanceErrorBound(model, max_distance, max_latitude) <= tolerance) {
+                        return model;
+                    }
+                }
+                return DistanceModel::HAVERSINE;
+            }
+
+            TrigCoordinates ComputeTrigCoordinates(Coordinates coordinates) {
+                return { coordinates.lat, coordinates.lng, std::sin(coordinates.lat * dr), std::cos(coordinates.lat * dr) };
+            }
+
+            double ComputeDistance(const TrigCoordinates& from, const TrigCoordinates& to) {
+                using namespace std;
+                if (from.lat == to.lat && from.lng == to.lng) {
+                    return 0;
+                }
+                return acos(from.sin_lat * to.sin_lat
+                    + from.cos_lat * to.cos_lat * cos(abs(from.lng - to.lng) * dr))
+                    * RADIUS_EARTH;
+            }
+
+            double ComputeDistance(const TrigCoordinates& from, const TrigCoordinates& to, DistanceModel model) {
+                const double lng_delta = LongitudeDelta(from.lng, to.lng);
+
+                switch (model) {
+                case DistanceModel::HAVERSINE:
+                    return Haversine(from.lat, to.lat, lng_delta, from.cos_lat, to.cos_lat);
+                case DistanceModel::EQUIRECTANGULAR:
+                    return Equirectangular(from.lat, to.lat, lng_delta, MeanLatitudeCos(from, to));
+                case DistanceModel::POLYNOMIAL:
+                    return Equirectangular(from.lat, to.lat, lng_delta, PolynomialCos((from.lat + to.lat) / 2.0 * dr));
+                default:
+                    return ComputeDistance(from, to);
+                }
+            }
+
+            void TrigSequence::Reserve(size_t size) {
+                lat.reserve(size);
+                lng.reserve(size);
+                sin_lat.reserve(size);
+                cos_lat.reserve(size);
+            }
+
+            void TrigSequence::PushBack(const TrigCoordinates& coordinates) {
+                lat.push_back(coordinates.lat);
+                lng.push_back(coordinates.lng);
+                sin_lat.push_back(coordinates.sin_lat);
+                cos_lat.push_back(coordinates.cos_lat);
+            }
+
+            size_t TrigSequence::Size() const {
+                return lat.size();
+            }
+
+            TrigCoordinates TrigSequence::At(size_t index) const {
+                return { lat[index], lng[index], sin_lat[index], cos_lat[index] };
+            }
+
+            double ComputeSequenceDistance(const TrigSequence& sequence, DistanceModel model) {
+                double distance = 0.0;
+                size_t to = 1;
+
+                if (model != DistanceModel::EQUIRECTANGULAR && model != DistanceModel::POLYNOMIAL) {
+                    for (; to < sequence.Size(); ++to) {
+                        distance += ComputeDistance(sequence.At(to - 1), sequence.At(to), model);
+                    }
+                    return distance;
+                }
+
+#ifdef __SSE2__
+                __m128d sum = _mm_setzero_pd();
+                for (; to + 1 < sequence.Size(); to += 2) {
+                    sum = _mm_add_pd(sum, SequenceHops(sequence, to, model));
+                }
+
+                double lanes[2];
+                _mm_storeu_pd(lanes, sum);
+                distance = lanes[0] + lanes[1];
+#endif
+                for (; to < sequence.Size(); ++to) {
+                    distance += SequenceHop(sequence, to, model);
+                }
+                return distance;
+            }
         } // namespace geo
     } // namespace detail
-}  // namespace transport_catalogue
\ No newline at end of file
+}  // namespace transport_catalogue
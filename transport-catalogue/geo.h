@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 const int RADIUS_EARTH = 6371000;
 const double NUMBER_PI = 3.1415926535;
+const double COORDINATE_SCALE = 1e7;    // единиц фиксированной точки в градусе, 1e-7 градуса - около 1.1 см
 
 namespace transport_catalogue {
     namespace detail {
@@ -18,7 +23,65 @@ namespace transport_catalogue {
                 }
             };
 
+            // Координаты в фиксированной точке - вдвое компактнее пары double
+            struct CompactCoordinates {
+                int32_t lat = 0;
+                int32_t lng = 0;
+            };
+
+            // Координаты с заранее вычисленными синусом и косинусом широты
+            struct TrigCoordinates {
+                double lat = 0.0;
+                double lng = 0.0;
+                double sin_lat = 0.0;
+                double cos_lat = 1.0;
+            };
+
+            // Последовательность точек в виде структуры массивов: соседние точки лежат подряд
+            // и читаются векторными загрузками
+            struct TrigSequence {
+                std::vector<double> lat;
+                std::vector<double> lng;
+                std::vector<double> sin_lat;
+                std::vector<double> cos_lat;
+
+                void Reserve(size_t size);
+                void PushBack(const TrigCoordinates& coordinates);
+                size_t Size() const;
+                TrigCoordinates At(size_t index) const;
+            };
+
+
+            // Модели расчёта расстояния. Погрешности указаны относительно точного расстояния по сфере
+            // для отрезка длиной d на широтах не выше phi (R - радиус Земли):
+            enum class DistanceModel {
+                SPHERICAL_COSINES,  // сферическая теорема косинусов: аргумент acos округляется с ошибкой до 2 eps, а acos(1 - x) ~ sqrt(2x),
+                                    // поэтому на коротких отрезках абсолютная ошибка до R sqrt(4 eps) ~ 0.19 м
+                HAVERSINE,          // формула гаверсинусов: точна на сфере, ошибка на уровне округления double
+                EQUIRECTANGULAR,    // равнопромежуточная проекция по средней широте: относительная ошибка не более (d/R)^2 / (8 cos^2 phi)
+                POLYNOMIAL          // та же проекция с полиномиальным косинусом без вызовов libm: плюс phi^12 / (12! cos phi)
+            };
+
+            CompactCoordinates EncodeCoordinates(Coordinates coordinates);
+            Coordinates DecodeCoordinates(CompactCoordinates coordinates);
+
             double ComputeDistance(Coordinates from, Coordinates to);
+            double ComputeDistance(Coordinates from, Coordinates to, DistanceModel model);
+
+            // Оценка сверху абсолютной ошибки модели в метрах для отрезков не длиннее max_distance
+            // на широтах не выше max_latitude (в градусах)
+            double GetDistanceErrorBound(DistanceModel model, double max_distance, double max_latitude);
+            // Самая дешёвая модель, ошибка которой не превышает tolerance метров
+            DistanceModel SelectDistanceModel(double max_distance, double max_latitude, double tolerance);
+
+            TrigCoordinates ComputeTrigCoordinates(Coordinates coordinates);
+            // Расстояние по закэшированным sin/cos широты: для SPHERICAL_COSINES и HAVERSINE без пересчёта синусов широт
+            double ComputeDistance(const TrigCoordinates& from, const TrigCoordinates& to);
+            double ComputeDistance(const TrigCoordinates& from, const TrigCoordinates& to, DistanceModel model);
+
+            // Длина ломаной по всем соседним парам последовательности. EQUIRECTANGULAR и POLYNOMIAL считаются
+            // без вызовов libm по две пары за шаг (SSE2), остальные модели - скалярно по одной паре
+            double ComputeSequenceDistance(const TrigSequence& sequence, DistanceModel model);
         } // namespace geo
     } // namespace detail
-}  // namespace transport_catalogue
\ No newline at end of file
+}  // namespace transport_catalogue
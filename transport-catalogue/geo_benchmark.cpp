@@ -0,0 +1,106 @@
+#include "geo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace transport_catalogue::detail::geo;
+
+// Сравнение пакетного ядра ComputeSequenceDistance со скалярным обходом пар по каждой модели.
+// Последовательность - случайное блуждание с шагом в несколько сотен метров, как остановки маршрута.
+// Запуск: geo_benchmark [число точек]
+
+namespace {
+
+    const int RUNS = 5;
+
+    // Лучшее время из RUNS запусков, в наносекундах на пару точек
+    template <typename Function>
+    double MeasureNanosecondsPerHop(Function function, size_t hops, double& result) {
+        double best = numeric_limits<double>::max();
+
+        for (int run = 0; run < RUNS; ++run) {
+            const auto start = chrono::steady_clock::now();
+            result = function();
+            const auto finish = chrono::steady_clock::now();
+
+            best = min(best, chrono::duration<double, nano>(finish - start).count() / static_cast<double>(hops));
+        }
+        return best;
+    }
+
+    string GetModelName(DistanceModel model) {
+        switch (model) {
+        case DistanceModel::SPHERICAL_COSINES:
+            return "spherical_cosines";
+        case DistanceModel::HAVERSINE:
+            return "haversine";
+        case DistanceModel::EQUIRECTANGULAR:
+            return "equirectangular";
+        case DistanceModel::POLYNOMIAL:
+            return "polynomial";
+        }
+        return "";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t point_count = argc > 1 ? static_cast<size_t>(atoll(argv[1])) : 1000000;
+    if (point_count < 2) {
+        cerr << "Usage: geo_benchmark [point_count >= 2]\n";
+        return 1;
+    }
+
+    mt19937 generator(42);
+    uniform_real_distribution<double> step(-0.004, 0.004);
+
+    vector<TrigCoordinates> points;
+    TrigSequence sequence;
+    points.reserve(point_count);
+    sequence.Reserve(point_count);
+
+    Coordinates position{ 55.6, 37.6 };
+    for (size_t i = 0; i < point_count; ++i) {
+        position.lat += step(generator);
+        position.lng += step(generator);
+
+        points.push_back(ComputeTrigCoordinates(position));
+        sequence.PushBack(points.back());
+    }
+
+    const size_t hops = point_count - 1;
+    cout << "points: " << point_count << '\n';
+    cout << left << setw(20) << "model" << right << setw(14) << "scalar ns/hop" << setw(14) << "batch ns/hop"
+         << setw(10) << "speedup" << setw(16) << "relative diff" << '\n';
+
+    for (DistanceModel model : { DistanceModel::SPHERICAL_COSINES, DistanceModel::HAVERSINE, DistanceModel::EQUIRECTANGULAR, DistanceModel::POLYNOMIAL }) {
+        double scalar_result = 0.0;
+        double batch_result = 0.0;
+
+        const double scalar_time = MeasureNanosecondsPerHop([&]() {
+            double distance = 0.0;
+            for (size_t i = 1; i < points.size(); ++i) {
+                distance += ComputeDistance(points[i - 1], points[i], model);
+            }
+            return distance;
+        }, hops, scalar_result);
+
+        const double batch_time = MeasureNanosecondsPerHop([&]() {
+            return ComputeSequenceDistance(sequence, model);
+        }, hops, batch_result);
+
+        cout << left << setw(20) << GetModelName(model) << right << fixed << setprecision(2)
+             << setw(14) << scalar_time << setw(14) << batch_time << setw(10) << scalar_time / batch_time
+             << scientific << setprecision(2) << setw(16) << abs(batch_result - scalar_result) / scalar_result << '\n';
+        cout.unsetf(ios::floatfield);
+    }
+    return 0;
+}
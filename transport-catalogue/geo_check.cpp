@@ -0,0 +1,134 @@
+#include "geo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace transport_catalogue::detail::geo;
+
+// Проверка моделей расстояния на фиксированных парах точек: каждая модель сравнивается с формулой гаверсинусов
+// (точна на сфере) и укладывается в свою оценку GetDistanceErrorBound, SPHERICAL_COSINES совпадает с прежним
+// ComputeDistance, а пакетное ядро - с суммой по парам. Ненулевой код возврата - проверка не прошла
+
+namespace {
+
+    const DistanceModel MODELS[] = { DistanceModel::SPHERICAL_COSINES, DistanceModel::HAVERSINE, DistanceModel::EQUIRECTANGULAR, DistanceModel::POLYNOMIAL };
+
+    struct CheckResult {
+        int checks = 0;
+        int failures = 0;
+
+        void Expect(bool condition, const string& message) {
+            ++checks;
+            if (!condition) {
+                ++failures;
+                cerr << "FAILED: " << message << '\n';
+            }
+        }
+    };
+
+    string Describe(DistanceModel model, Coordinates from, Coordinates to) {
+        return "model " + to_string(static_cast<int>(model)) + " (" + to_string(from.lat) + ", " + to_string(from.lng)
+            + ") -> (" + to_string(to.lat) + ", " + to_string(to.lng) + ")";
+    }
+
+    // Отрезки от сантиметров до десятков километров на широтах от экватора до 70 градусов, в разных направлениях
+    vector<pair<Coordinates, Coordinates>> MakePairs() {
+        vector<pair<Coordinates, Coordinates>> pairs;
+
+        for (double lat : { 0.0, 30.0, -45.0, 55.75, 70.0 }) {
+            for (double offset : { 1e-7, 1e-5, 1e-4, 1e-3, 1e-2, 0.1, 0.3 }) {
+                const Coordinates from{ lat, 37.6 };
+                pairs.push_back({ from, { lat + offset, 37.6 } });
+                pairs.push_back({ from, { lat, 37.6 + offset } });
+                pairs.push_back({ from, { lat - offset, 37.6 + 2.0 * offset } });
+            }
+        }
+        // Отрезок через антимеридиан
+        pairs.push_back({ { 10.0, 179.999 }, { 10.001, -179.999 } });
+        return pairs;
+    }
+
+    void CheckModels(const vector<pair<Coordinates, Coordinates>>& pairs, CheckResult& result) {
+        for (const auto& [from, to] : pairs) {
+            const double reference = ComputeDistance(from, to, DistanceModel::HAVERSINE);
+            const double max_latitude = max(abs(from.lat), abs(to.lat));
+            const TrigCoordinates trig_from = ComputeTrigCoordinates(from);
+            const TrigCoordinates trig_to = ComputeTrigCoordinates(to);
+
+            // Закон косинусов - прежний результат ComputeDistance, модели и кэш синусов его не меняют
+            result.Expect(ComputeDistance(from, to, DistanceModel::SPHERICAL_COSINES) == ComputeDistance(from, to),
+                          Describe(DistanceModel::SPHERICAL_COSINES, from, to) + " differs from ComputeDistance");
+            result.Expect(ComputeDistance(trig_from, trig_to) == ComputeDistance(from, to),
+                          Describe(DistanceModel::SPHERICAL_COSINES, from, to) + " with cached trig differs from ComputeDistance");
+
+            for (DistanceModel model : MODELS) {
+                const double bound = GetDistanceErrorBound(model, reference, max_latitude)
+                    + GetDistanceErrorBound(DistanceModel::HAVERSINE, reference, max_latitude);
+
+                for (double distance : { ComputeDistance(from, to, model), ComputeDistance(trig_from, trig_to, model) }) {
+                    result.Expect(abs(distance - reference) <= bound,
+                                  Describe(model, from, to) + ": error " + to_string(abs(distance - reference)) + " m, bound " + to_string(bound) + " m");
+                }
+            }
+        }
+    }
+
+    // Выбранная модель укладывается в допуск на всех отрезках не длиннее max_distance
+    void CheckSelection(const vector<pair<Coordinates, Coordinates>>& pairs, CheckResult& result) {
+        for (double tolerance : { 0.001, 0.01, 1.0 }) {
+            for (double max_distance : { 100.0, 1000.0, 10000.0 }) {
+                const DistanceModel model = SelectDistanceModel(max_distance, 70.0, tolerance);
+
+                for (const auto& [from, to] : pairs) {
+                    const double reference = ComputeDistance(from, to, DistanceModel::HAVERSINE);
+                    if (reference > max_distance || max(abs(from.lat), abs(to.lat)) > 70.0) {
+                        continue;
+                    }
+                    const double error = abs(ComputeDistance(from, to, model) - reference);
+                    result.Expect(error <= tolerance + GetDistanceErrorBound(DistanceModel::HAVERSINE, reference, 70.0),
+                                  Describe(model, from, to) + ": selected for tolerance " + to_string(tolerance) + " m, error " + to_string(error) + " m");
+                }
+            }
+        }
+    }
+
+    // Пакетное ядро считает те же отрезки, что и скалярный обход пар; отличается только порядок сложения
+    void CheckSequence(const vector<pair<Coordinates, Coordinates>>& pairs, CheckResult& result) {
+        TrigSequence sequence;
+        vector<TrigCoordinates> points;
+
+        for (const auto& [from, to] : pairs) {
+            for (Coordinates point : { from, to }) {
+                points.push_back(ComputeTrigCoordinates(point));
+                sequence.PushBack(points.back());
+            }
+        }
+
+        for (DistanceModel model : MODELS) {
+            double expected = 0.0;
+            for (size_t i = 1; i < points.size(); ++i) {
+                expected += ComputeDistance(points[i - 1], points[i], model);
+            }
+            const double batch = ComputeSequenceDistance(sequence, model);
+
+            result.Expect(abs(batch - expected) <= expected * 1e-12,
+                          "sequence of model " + to_string(static_cast<int>(model)) + ": " + to_string(batch) + " m instead of " + to_string(expected) + " m");
+        }
+    }
+}
+
+int main() {
+    const auto pairs = MakePairs();
+    CheckResult result;
+
+    CheckModels(pairs, result);
+    CheckSelection(pairs, result);
+    CheckSequence(pairs, result);
+
+    cout << "geo_check: " << result.checks << " checks, " << result.failures << " failed\n";
+    return result.failures == 0 ? 0 : 1;
+}
@@ -27,6 +27,8 @@ public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    // Меняет только вес ребра, структура графа остаётся прежней
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
@@ -51,6 +53,11 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     return id;
 }
 
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    edges_.at(edge_id).weight = weight;
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -71,4 +78,21 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+// Путь задан цепочкой предшественников от последнего ребра к первому: prev_edge(edge_id) - ребро перед edge_id.
+// Рёбра передаются visitor в порядке следования. Цепочка разворачивается в буфере потока, поэтому после первых
+// маршрутов память не выделяется; visitor может сам обходить другие пути - они занимают буфер после текущего
+template <typename PrevEdge, typename Visitor>
+void VisitEdgeChain(EdgeId last_edge, EdgeId no_edge, PrevEdge prev_edge, Visitor&& visitor) {
+    thread_local std::vector<EdgeId> chain;
+    const size_t begin = chain.size();
+
+    for (EdgeId edge_id = last_edge; edge_id != no_edge; edge_id = prev_edge(edge_id)) {
+        chain.push_back(edge_id);
+    }
+    for (size_t i = chain.size(); i > begin; --i) {
+        visitor(chain[i - 1]);
+    }
+    chain.resize(begin);
+}
 }  // namespace graph
\ No newline at end of file
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "dijkstra.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Метки хабов (pruned landmark labeling) для запросов веса кратчайшего пути без самого пути.
+// У вершины есть исходящая метка - хабы, достижимые из неё, и входящая - хабы, из которых достижима она.
+// Вес пути from -> to - минимум суммы по общим хабам, метки отсортированы по рангу хаба и сливаются за один проход.
+// Метки хранятся только для выбранных вершин-терминалов, их номер - индекс в списке терминалов
+template <typename Weight>
+class HubLabels {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    struct Label {
+        uint32_t hub;       // ранг хаба в порядке построения
+        Weight weight;
+    };
+
+    HubLabels() = default;
+    // Строит метки по всему графу и оставляет их только для terminals
+    HubLabels(const Graph& graph, const std::vector<VertexId>& terminals);
+    // Готовые метки в формате CSR: метки терминала i лежат в [begin[i], begin[i + 1])
+    HubLabels(std::vector<uint32_t> out_begin, std::vector<Label> out_labels,
+              std::vector<uint32_t> in_begin, std::vector<Label> in_labels);
+
+    bool IsEmpty() const {
+        return out_begin_.empty();
+    }
+    size_t GetTerminalCount() const {
+        return out_begin_.empty() ? 0 : out_begin_.size() - 1;
+    }
+
+    std::optional<Weight> GetRouteWeight(size_t from, size_t to) const;
+
+    const std::vector<uint32_t>& GetOutBegin() const {
+        return out_begin_;
+    }
+    const std::vector<Label>& GetOutLabels() const {
+        return out_labels_;
+    }
+    const std::vector<uint32_t>& GetInBegin() const {
+        return in_begin_;
+    }
+    const std::vector<Label>& GetInLabels() const {
+        return in_labels_;
+    }
+
+private:
+    using LabelList = std::vector<Label>;
+
+    static std::optional<Weight> MergeLabels(const Label* out_first, const Label* out_last,
+                                             const Label* in_first, const Label* in_last);
+    static void BuildCsr(const std::vector<LabelList>& labels, const std::vector<VertexId>& terminals,
+                         std::vector<uint32_t>& begin, std::vector<Label>& flat);
+
+    std::vector<uint32_t> out_begin_;
+    std::vector<Label> out_labels_;
+    std::vector<uint32_t> in_begin_;
+    std::vector<Label> in_labels_;
+};
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(const Graph& graph, const std::vector<VertexId>& terminals) {
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+    static constexpr Weight ZERO_WEIGHT{};
+
+    const size_t vertex_count = graph.GetVertexCount();
+    if (vertex_count >= std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Too many vertices for hub labels");
+    }
+
+    // Обратные списки рёбер для поиска в сторону входящих рёбер
+    std::vector<std::vector<EdgeId>> incoming(vertex_count);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        incoming[graph.GetEdge(edge_id).to].push_back(edge_id);
+    }
+
+    // Сначала хабы с наибольшей степенью - через них проходит больше кратчайших путей
+    std::vector<VertexId> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0);
+    auto degree = [&graph, &incoming](VertexId vertex) {
+        const auto edges = graph.GetIncidentEdges(vertex);
+        return static_cast<size_t>(std::distance(edges.begin(), edges.end())) + incoming[vertex].size();
+    };
+    std::stable_sort(order.begin(), order.end(), [&degree](VertexId lhs, VertexId rhs) {
+        return degree(lhs) > degree(rhs);
+    });
+
+    std::vector<LabelList> out_labels(vertex_count);
+    std::vector<LabelList> in_labels(vertex_count);
+    std::vector<Weight> weights(vertex_count, UNREACHABLE);
+    std::vector<VertexId> touched;
+
+    auto query = [](const LabelList& out, const LabelList& in) {
+        return MergeLabels(out.data(), out.data() + out.size(), in.data(), in.data() + in.size());
+    };
+
+    // Поиск Дейкстры от хаба, отсечённый там, где уже известные метки дают путь не длиннее
+    auto pruned_search = [&](VertexId hub, uint32_t rank, bool forward) {
+        DijkstraQueue<Weight> queue;
+        weights[hub] = ZERO_WEIGHT;
+        touched.push_back(hub);
+        queue.Push(ZERO_WEIGHT, hub);
+
+        while (!queue.IsEmpty()) {
+            const auto [weight, vertex] = queue.Pop();
+            if (weight > weights[vertex]) {
+                continue;
+            }
+
+            const auto known = forward ? query(out_labels[hub], in_labels[vertex]) : query(out_labels[vertex], in_labels[hub]);
+            if (known && *known <= weight) {
+                continue;
+            }
+            (forward ? in_labels[vertex] : out_labels[vertex]).push_back({rank, weight});
+
+            auto relax = [&](EdgeId edge_id, VertexId next) {
+                const Weight candidate = weight + graph.GetEdge(edge_id).weight;
+                if (candidate < weights[next]) {
+                    if (weights[next] == UNREACHABLE) {
+                        touched.push_back(next);
+                    }
+                    weights[next] = candidate;
+                    queue.Push(candidate, next);
+                }
+            };
+
+            if (forward) {
+                for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                    relax(edge_id, graph.GetEdge(edge_id).to);
+                }
+            } else {
+                for (const EdgeId edge_id : incoming[vertex]) {
+                    relax(edge_id, graph.GetEdge(edge_id).from);
+                }
+            }
+        }
+
+        for (const VertexId vertex : touched) {
+            weights[vertex] = UNREACHABLE;
+        }
+        touched.clear();
+    };
+
+    for (uint32_t rank = 0; rank < vertex_count; ++rank) {
+        pruned_search(order[rank], rank, true);
+        pruned_search(order[rank], rank, false);
+    }
+
+    BuildCsr(out_labels, terminals, out_begin_, out_labels_);
+    BuildCsr(in_labels, terminals, in_begin_, in_labels_);
+}
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(std::vector<uint32_t> out_begin, std::vector<Label> out_labels,
+                             std::vector<uint32_t> in_begin, std::vector<Label> in_labels)
+    : out_begin_(std::move(out_begin))
+    , out_labels_(std::move(out_labels))
+    , in_begin_(std::move(in_begin))
+    , in_labels_(std::move(in_labels))
+{
+    if (out_begin_.size() != in_begin_.size()
+        || (!out_begin_.empty() && (out_begin_.back() != out_labels_.size() || in_begin_.back() != in_labels_.size()))) {
+        throw std::invalid_argument("Hub labels are inconsistent");
+    }
+}
+
+template <typename Weight>
+std::optional<Weight> HubLabels<Weight>::GetRouteWeight(size_t from, size_t to) const {
+    return MergeLabels(out_labels_.data() + out_begin_.at(from), out_labels_.data() + out_begin_.at(from + 1),
+                       in_labels_.data() + in_begin_.at(to), in_labels_.data() + in_begin_.at(to + 1));
+}
+
+template <typename Weight>
+std::optional<Weight> HubLabels<Weight>::MergeLabels(const Label* out_first, const Label* out_last,
+                                                     const Label* in_first, const Label* in_last) {
+    std::optional<Weight> result;
+    while (out_first != out_last && in_first != in_last) {
+        if (out_first->hub < in_first->hub) {
+            ++out_first;
+        } else if (in_first->hub < out_first->hub) {
+            ++in_first;
+        } else {
+            const Weight weight = out_first->weight + in_first->weight;
+            if (!result || weight < *result) {
+                result = weight;
+            }
+            ++out_first;
+            ++in_first;
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+void HubLabels<Weight>::BuildCsr(const std::vector<LabelList>& labels, const std::vector<VertexId>& terminals,
+                                 std::vector<uint32_t>& begin, std::vector<Label>& flat) {
+    begin.assign(1, 0);
+    for (const VertexId terminal : terminals) {
+        flat.insert(flat.end(), labels.at(terminal).begin(), labels.at(terminal).end());
+        begin.push_back(static_cast<uint32_t>(flat.size()));
+    }
+}
+
+}  // namespace graph
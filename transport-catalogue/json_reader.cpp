@@ -10,30 +10,27 @@ namespace transport_catalogue {
                 : document_(json::Load(input)) {}
 
             void JsonReader::ParseNodeBase(const Node& root, TransportCatalogue& catalogue) {
-                Array base_requests;
-                Dict req_map;
-                Node req_node;
-
-                std::vector<Node> buses;
-                std::vector<Node> stops;
+                // Запросы не копируются: на больших базах копии узлов занимали больше памяти, чем сам документ
+                std::vector<const Node*> buses;
+                std::vector<const Node*> stops;
 
                 if (root.IsArray()) {
-                    base_requests = root.AsArray();
+                    const Array& base_requests = root.AsArray();
 
-                    for (Node& node : base_requests) {
+                    for (const Node& node : base_requests) {
                         if (node.IsDict()) {
-                            req_map = node.AsDict();
+                            const Dict& req_map = node.AsDict();
 
                             try {
-                                req_node = req_map.at("type");
+                                const Node& req_node = req_map.at("type");
                                 if (req_node.IsString()) {
 
                                     if (req_node.AsString() == "Bus") {
-                                        buses.push_back(req_map);
+                                        buses.push_back(&node);
 
                                     }
                                     else if (req_node.AsString() == "Stop") {
-                                        stops.push_back(req_map);
+                                        stops.push_back(&node);
 
                                     }
                                     else {
@@ -48,16 +45,16 @@ namespace transport_catalogue {
                         }
                     }
 
-                    for (auto stop : stops) {
-                        catalogue.AddStop(ParseNodeStop(stop));
+                    for (const Node* stop : stops) {
+                        catalogue.AddStop(ParseNodeStop(*stop));
                     }
 
-                    for (auto stop : stops) {
-                        catalogue.AddDistance(ParseNodeDistances(stop, catalogue));
+                    for (const Node* stop : stops) {
+                        catalogue.AddDistance(ParseNodeDistances(*stop, catalogue));
                     }
 
-                    for (auto bus : buses) {
-                        catalogue.AddBus(ParseNodeBus(bus, catalogue));
+                    for (const Node* bus : buses) {
+                        catalogue.AddBus(ParseNodeBus(*bus, catalogue));
                     }
 
                 }
@@ -205,14 +202,44 @@ namespace transport_catalogue {
                             } else {
                                 req.name = "";
                                 req.name = "";
+                                req.from_stops.clear();
+                                req.to_stops.clear();
+
+                                if (req.type == "RouteMatrix") {
+                                    for (const Node& stop : req_map.at("from").AsArray()) {
+                                        req.from_stops.push_back(stop.AsString());
+                                    }
+                                    for (const Node& stop : req_map.at("to").AsArray()) {
+                                        req.to_stops.push_back(stop.AsString());
+                                    }
+                                }
+
                                 if (req.type == "Route") {
                                     req.from = req_map.at("from").AsString();
                                     req.to = req_map.at("to").AsString();
+                                    req.alternatives = req_map.count("alternatives") ? req_map.at("alternatives").AsInt() : 1;
+                                    req.profile = req_map.count("profile") ? req_map.at("profile").AsString() : "";
+                                    req.itinerary = req_map.count("itinerary") ? req_map.at("itinerary").AsBool() : true;
+                                }
+                                else if (req.type == "Isochrone") {
+                                    req.from = req_map.at("from").AsString();
+                                    req.to = "";
+                                    req.max_time = req_map.at("max_time").AsDouble();
+                                    req.profile = req_map.count("profile") ? req_map.at("profile").AsString() : "";
                                 }
                                 else {
                                     req.from = "";
                                     req.to = "";
                                 }
+
+                                if (req.type == "NearestStops") {
+                                    req.coordinates = { req_map.at("latitude").AsDouble(), req_map.at("longitude").AsDouble() };
+                                    req.count = req_map.count("count") ? req_map.at("count").AsInt() : 1;
+                                }
+                                else if (req.type == "StopsInBBox") {
+                                    req.min_coordinates = { req_map.at("min_latitude").AsDouble(), req_map.at("min_longitude").AsDouble() };
+                                    req.max_coordinates = { req_map.at("max_latitude").AsDouble(), req_map.at("max_longitude").AsDouble() };
+                                }
                             }
                             stat_request.push_back(req);
                         }
@@ -225,34 +252,35 @@ namespace transport_catalogue {
                 ParseNode(document_.GetRoot(), catalogue, stat_request, render_settings, routing_settings);
             }
 
-            Stop JsonReader::ParseNodeStop(Node& node) {
+            Stop JsonReader::ParseNodeStop(const Node& node) {
                 Stop stop;
-                Dict stop_node;
 
                 if (node.IsDict()) {
 
-                    stop_node = node.AsDict();
+                    const Dict& stop_node = node.AsDict();
                     stop.name_stop = stop_node.at("name").AsString();
                     stop.latitude = stop_node.at("latitude").AsDouble();
                     stop.longitude = stop_node.at("longitude").AsDouble();
+
+                    if (stop_node.count("region")) {
+                        stop.region = stop_node.at("region").AsString();
+                    }
                 }
 
                 return stop;
             }
-            Bus JsonReader::ParseNodeBus(Node& node, TransportCatalogue& catalogue) {
+            Bus JsonReader::ParseNodeBus(const Node& node, TransportCatalogue& catalogue) {
                 Bus bus;
-                Dict bus_node;
-                Array bus_stops;
 
                 if (node.IsDict()) {
-                    bus_node = node.AsDict();
+                    const Dict& bus_node = node.AsDict();
                     bus.name_bus = bus_node.at("name").AsString();
                     bus.is_roundtrip = bus_node.at("is_roundtrip").AsBool();
 
                     try {
-                        bus_stops = bus_node.at("stops").AsArray();
+                        const Array& bus_stops = bus_node.at("stops").AsArray();
 
-                        for (Node stop : bus_stops) {
+                        for (const Node& stop : bus_stops) {
                             bus.stops_bus.push_back(catalogue.FindStop(stop.AsString()));
                         }
 
@@ -270,27 +298,20 @@ namespace transport_catalogue {
                 }
                 return bus;
             }
-            std::vector<Distance> JsonReader::ParseNodeDistances(Node& node, TransportCatalogue& catalogue) {
+            std::vector<Distance> JsonReader::ParseNodeDistances(const Node& node, TransportCatalogue& catalogue) {
                 std::vector<Distance> distances;
-                Dict stop_node;
-                Dict stop_road_map;
-                std::string begin_name;
-                std::string last_name;
-                int distance;
 
                 if (node.IsDict()) {
-                    stop_node = node.AsDict();
-                    begin_name = stop_node.at("name").AsString();
+                    const Dict& stop_node = node.AsDict();
+                    const Stop* begin_stop = catalogue.FindStop(stop_node.at("name").AsString());
 
                     try {
-                        stop_road_map = stop_node.at("road_distances").AsDict();
-
-                        for (auto [key, value] : stop_road_map) {
-                            last_name = key;
-                            distance = value.AsInt();
-                            distances.push_back({ catalogue.FindStop(begin_name),
-                                                 catalogue.FindStop(last_name),
-                                                 distance });
+                        const Dict& stop_road_map = stop_node.at("road_distances").AsDict();
+
+                        for (const auto& [key, value] : stop_road_map) {
+                            distances.push_back({ begin_stop,
+                                                 catalogue.FindStop(key),
+                                                 value.AsInt() });
                         }
                     }
 
@@ -310,6 +331,20 @@ namespace transport_catalogue {
                     try {
                         route_set.bus_wait_time = route.at("bus_wait_time").AsDouble();
                         route_set.bus_velocity = route.at("bus_velocity").AsDouble();
+
+                        // Пешие пересадки строятся при make_base и хранятся в базе, поэтому переопределить их нельзя
+                        if (route.count("walking_radius")) {
+                            route_set.walking_radius = route.at("walking_radius").AsDouble();
+                        }
+                        if (route.count("walking_velocity")) {
+                            route_set.walking_velocity = route.at("walking_velocity").AsDouble();
+                        }
+                        // Таблица всех пар пишется при make_base по графу базы
+                        if (route.count("route_table_file")) {
+                            route_set.route_table_file = route.at("route_table_file").AsString();
+                        }
+
+                        ParseRoutingOptions(route, route_set);
                     }
                     catch (...) {
                         std::cout << "unable to parse routing settings";
@@ -319,6 +354,77 @@ namespace transport_catalogue {
                     std::cout << "routing settings is not map";
                 }
             }
+            // Ключи настроек маршрутизации, которые можно не указывать
+            void JsonReader::ParseRoutingOptions(const Dict& route, router::RoutingSettings& route_set) {
+                if (route.count("bus_wait_time")) {
+                    route_set.bus_wait_time = route.at("bus_wait_time").AsDouble();
+                }
+                if (route.count("bus_velocity")) {
+                    route_set.bus_velocity = route.at("bus_velocity").AsDouble();
+                }
+                if (route.count("router")) {
+                    const std::string& router_mode = route.at("router").AsString();
+
+                    if (router_mode == "lazy") {
+                        route_set.router_mode = router::RouterMode::LAZY;
+                    }
+                    else if (router_mode == "arc_flags") {
+                        route_set.router_mode = router::RouterMode::ARC_FLAGS;
+                    }
+                    else {
+                        route_set.router_mode = router::RouterMode::ALL_PAIRS;
+                    }
+                }
+                if (route.count("hub_labels")) {
+                    route_set.hub_labels = route.at("hub_labels").AsBool();
+                }
+                if (route.count("router_memory_mb")) {
+                    route_set.router_memory_mb = route.at("router_memory_mb").AsInt();
+                }
+                if (route.count("route_cache_size")) {
+                    route_set.route_cache_size = route.at("route_cache_size").AsInt();
+                }
+                if (route.count("route_table_huge_pages")) {
+                    route_set.route_table_huge_pages = route.at("route_table_huge_pages").AsBool();
+                }
+                if (route.count("route_weights")) {
+                    const std::string& route_weights = route.at("route_weights").AsString();
+
+                    if (route_weights == "deciseconds" || route_weights == "uint32") {
+                        route_set.route_weight = router::RouteWeight::DECISECONDS;
+                    }
+                    else if (route_weights == "float") {
+                        route_set.route_weight = router::RouteWeight::FLOAT;
+                    }
+                    else {
+                        route_set.route_weight = router::RouteWeight::DOUBLE;
+                    }
+                }
+                // Профили: {"имя": {"bus_wait_time": ..., "bus_velocity": ...}}, неуказанное берётся из основных настроек.
+                // Профиль с уже известным именем заменяется
+                if (route.count("profiles")) {
+                    for (const auto& [name, profile_node] : route.at("profiles").AsDict()) {
+                        const Dict& profile_map = profile_node.AsDict();
+                        router::RoutingProfile profile{ name, route_set.bus_wait_time, route_set.bus_velocity };
+
+                        if (profile_map.count("bus_wait_time")) {
+                            profile.bus_wait_time = profile_map.at("bus_wait_time").AsDouble();
+                        }
+                        if (profile_map.count("bus_velocity")) {
+                            profile.bus_velocity = profile_map.at("bus_velocity").AsDouble();
+                        }
+
+                        auto it = std::find_if(route_set.profiles.begin(), route_set.profiles.end(),
+                            [&name](const router::RoutingProfile& known) { return known.name == name; });
+                        if (it != route_set.profiles.end()) {
+                            *it = std::move(profile);
+                        }
+                        else {
+                            route_set.profiles.push_back(std::move(profile));
+                        }
+                    }
+                }
+            }
             void JsonReader::ParseNodeSerialization(const Node& node, serialization::SerializationSettings& serialization_set) {
 
                 Dict serialization;
@@ -329,6 +435,23 @@ namespace transport_catalogue {
                     try {
                         serialization_set.file_name = serialization.at("file").AsString();
 
+                        if (serialization.count("compact_coordinates")) {
+                            serialization_set.compact_coordinates = serialization.at("compact_coordinates").AsBool();
+                        }
+
+                        if (serialization.count("columnar")) {
+                            serialization_set.columnar = serialization.at("columnar").AsBool();
+                        }
+
+                        if (serialization.count("format")) {
+                            if (serialization.at("format").AsString() == "flat") {
+                                serialization_set.format = serialization::BaseFormat::FLAT;
+                            }
+                            else {
+                                serialization_set.format = serialization::BaseFormat::PROTOBUF;
+                            }
+                        }
+
                     }
                     catch (...) {
                         std::cout << "unable to parse serialization settings";
@@ -341,10 +464,8 @@ namespace transport_catalogue {
             }
 
             void JsonReader::ParseNodeMakeBase(TransportCatalogue& catalogue, map_renderer::RenderSettings& render_settings, router::RoutingSettings& routing_settings, serialization::SerializationSettings& serialization_settings) {
-                Dict root_dictionary;
-
                 if (document_.GetRoot().IsDict()) {
-                    root_dictionary = document_.GetRoot().AsDict();
+                    const Dict& root_dictionary = document_.GetRoot().AsDict();
 
                     try {
                         ParseNodeBase(root_dictionary.at("base_requests"), catalogue);
@@ -400,6 +521,31 @@ namespace transport_catalogue {
                 }
             }
 
+            // Настройки маршрутизации в process_requests заменяют сохранённые в базе только по указанным ключам.
+            // Граф при этом не перестраивается - меняются лишь веса рёбер
+            void JsonReader::ParseNodeRoutingOverride(router::RoutingSettings& routing_settings) {
+                if (!document_.GetRoot().IsDict()) {
+                    return;
+                }
+
+                const Dict& root_dictionary = document_.GetRoot().AsDict();
+                if (!root_dictionary.count("routing_settings")) {
+                    return;
+                }
+
+                // Настройки разбираются в копию и применяются целиком. При ошибке остаются настройки из базы, а сообщение
+                // уходит в std::cerr - std::cout здесь занят ответом на запросы
+                router::RoutingSettings parsed_settings = routing_settings;
+                try {
+                    ParseRoutingOptions(root_dictionary.at("routing_settings").AsDict(), parsed_settings);
+                }
+                catch (const std::exception& error) {
+                    std::cerr << "unable to parse routing settings: " << error.what() << std::endl;
+                    return;
+                }
+                routing_settings = std::move(parsed_settings);
+            }
+
         }//end namespace json
     }//end namespace detail
 }//end namespace transport_catalogue
\ No newline at end of file
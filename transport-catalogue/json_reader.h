@@ -22,14 +22,16 @@ namespace transport_catalogue {
                 void ParceNodeStat(const Node& node, std::vector<StatRequest>& stat_request);
                 void Parse(TransportCatalogue& catalogue, std::vector<StatRequest>& stat_request, map_renderer::RenderSettings& render_settings, router::RoutingSettings& routing_settings);
                 void ParceNodeRouting(const Node& node, router::RoutingSettings& route_set);
+                void ParseRoutingOptions(const Dict& route, router::RoutingSettings& route_set);
 
-                Stop ParseNodeStop(Node& node);
-                Bus ParseNodeBus(Node& node, TransportCatalogue& catalogue);
-                std::vector<Distance> ParseNodeDistances(Node& node, TransportCatalogue& catalogue);
+                Stop ParseNodeStop(const Node& node);
+                Bus ParseNodeBus(const Node& node, TransportCatalogue& catalogue);
+                std::vector<Distance> ParseNodeDistances(const Node& node, TransportCatalogue& catalogue);
                 void ParseNodeSerialization(const Node& node, serialization::SerializationSettings& serialization_set);
 
                 void ParseNodeMakeBase(TransportCatalogue& catalogue, map_renderer::RenderSettings& render_settings, router::RoutingSettings& routing_settings, serialization::SerializationSettings& serialization_settings);
                 void ParseNodeProcessRequests(std::vector<StatRequest>& stat_request, serialization::SerializationSettings& serialization_settings);
+                void ParseNodeRoutingOverride(router::RoutingSettings& routing_settings);
 
 
             private:
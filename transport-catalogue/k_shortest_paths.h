@@ -0,0 +1,84 @@
+#pragma once
+
+#include "dijkstra.h"
+#include "router.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+namespace graph {
+
+// k лучших различных маршрутов без циклов (алгоритм Йена).
+// shortest - уже найденный кратчайший маршрут from -> to, он идёт в ответ первым.
+// Маршруты тяжелее shortest.weight * max_stretch не рассматриваются: это ограничивает
+// каждый поиск ответвления и не даёт стоимости расти вместе с длиной списка кандидатов
+template <typename Weight>
+std::vector<typename RouterEngine<Weight>::RouteInfo> FindKShortestPaths(const DirectedWeightedGraph<Weight>& graph,
+                                                                         const typename RouterEngine<Weight>::RouteInfo& shortest,
+                                                                         VertexId from, VertexId to,
+                                                                         size_t k, double max_stretch) {
+    using RouteInfo = typename RouterEngine<Weight>::RouteInfo;
+
+    std::vector<RouteInfo> routes{shortest};
+    std::vector<RouteInfo> candidates;
+    const Weight max_weight = static_cast<Weight>(shortest.weight * max_stretch);
+
+    auto is_known = [&routes, &candidates](const std::vector<EdgeId>& edges) {
+        auto same_edges = [&edges](const RouteInfo& route) { return route.edges == edges; };
+        return std::any_of(routes.begin(), routes.end(), same_edges)
+            || std::any_of(candidates.begin(), candidates.end(), same_edges);
+    };
+
+    while (routes.size() < k) {
+        const std::vector<EdgeId> previous = routes.back().edges;
+
+        std::unordered_set<VertexId> banned_vertices;
+        Weight root_weight{};
+        VertexId spur_vertex = from;
+
+        // Ответвление от каждой вершины предыдущего маршрута
+        for (size_t spur = 0; spur < previous.size(); ++spur) {
+            std::unordered_set<EdgeId> banned_edges;
+            for (const auto& route : routes) {
+                if (route.edges.size() > spur && std::equal(previous.begin(), previous.begin() + spur, route.edges.begin())) {
+                    banned_edges.insert(route.edges[spur]);
+                }
+            }
+
+            if (root_weight <= max_weight) {
+                auto edge_filter = [&graph, &banned_edges, &banned_vertices](EdgeId edge_id) {
+                    return !banned_edges.count(edge_id) && !banned_vertices.count(graph.GetEdge(edge_id).to);
+                };
+                const auto tree = BuildShortestPathTree(graph, spur_vertex, std::optional<Weight>(max_weight - root_weight),
+                                                        std::optional<VertexId>(to), edge_filter);
+
+                if (tree.IsReachable(to)) {
+                    std::vector<EdgeId> edges(previous.begin(), previous.begin() + spur);
+                    const auto spur_edges = tree.GetPathEdges(graph, to);
+                    edges.insert(edges.end(), spur_edges.begin(), spur_edges.end());
+
+                    if (!is_known(edges)) {
+                        candidates.push_back({root_weight + tree.weights[to], std::move(edges)});
+                    }
+                }
+            }
+
+            banned_vertices.insert(spur_vertex);
+            root_weight += graph.GetEdge(previous[spur]).weight;
+            spur_vertex = graph.GetEdge(previous[spur]).to;
+        }
+
+        if (candidates.empty()) {
+            break;
+        }
+        const auto best = std::min_element(candidates.begin(), candidates.end(), [](const RouteInfo& lhs, const RouteInfo& rhs) {
+            return lhs.weight < rhs.weight;
+        });
+        routes.push_back(std::move(*best));
+        candidates.erase(best);
+    }
+    return routes;
+}
+
+}  // namespace graph
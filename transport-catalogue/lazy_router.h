@@ -0,0 +1,103 @@
+#pragma once
+
+#include "dijkstra.h"
+#include "router.h"
+
+#include <list>
+#include <unordered_map>
+
+namespace graph {
+
+// Маршрутизатор без предварительного расчёта всех пар вершин.
+// Дерево кратчайших путей от вершины строится при первом запросе из неё и запоминается;
+// при превышении лимита памяти вытесняется дерево, которое дольше всех не использовалось.
+// Queue - очередь поиска Дейкстры, каждое дерево строится на копии queue из конструктора
+template <typename Weight, typename Queue = DijkstraQueue<Weight>>
+class LazyRouter : public RouterEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using Tree = ShortestPathTree<Weight>;
+
+public:
+    using RouteInfo = typename RouterEngine<Weight>::RouteInfo;
+    using EdgeVisitor = typename RouterEngine<Weight>::EdgeVisitor;
+
+    // max_memory - лимит памяти под деревья в байтах, хотя бы одно дерево хранится всегда
+    LazyRouter(const Graph& graph, size_t max_memory, Queue queue = {});
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const override;
+    std::optional<Weight> VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const override;
+
+    size_t GetMaxRows() const {
+        return max_rows_;
+    }
+    size_t GetCachedRows() const {
+        return rows_.size();
+    }
+
+private:
+    const Tree& GetTree(VertexId from) const;
+
+    const Graph& graph_;
+    size_t max_rows_;
+    Queue queue_;
+
+    mutable std::list<VertexId> lru_;   // в начале - последние использованные
+    mutable std::unordered_map<VertexId, std::pair<typename std::list<VertexId>::iterator, Tree>> rows_;
+};
+
+template <typename Weight, typename Queue>
+LazyRouter<Weight, Queue>::LazyRouter(const Graph& graph, size_t max_memory, Queue queue)
+    : graph_(graph)
+    , queue_(std::move(queue))
+{
+    const size_t row_size = std::max<size_t>(graph.GetVertexCount() * (sizeof(Weight) + sizeof(EdgeId)), 1);
+    max_rows_ = std::max<size_t>(max_memory / row_size, 1);
+}
+
+template <typename Weight, typename Queue>
+std::optional<typename LazyRouter<Weight, Queue>::RouteInfo> LazyRouter<Weight, Queue>::BuildRoute(VertexId from,
+                                                                                                   VertexId to) const {
+    const Tree& tree = GetTree(from);
+    if (!tree.IsReachable(to)) {
+        return std::nullopt;
+    }
+    return RouteInfo{tree.weights[to], tree.GetPathEdges(graph_, to)};
+}
+
+template <typename Weight, typename Queue>
+std::optional<Weight> LazyRouter<Weight, Queue>::GetRouteWeight(VertexId from, VertexId to) const {
+    const Tree& tree = GetTree(from);
+    if (!tree.IsReachable(to)) {
+        return std::nullopt;
+    }
+    return tree.weights[to];
+}
+
+template <typename Weight, typename Queue>
+std::optional<Weight> LazyRouter<Weight, Queue>::VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const {
+    const Tree& tree = GetTree(from);
+    if (!tree.IsReachable(to)) {
+        return std::nullopt;
+    }
+    tree.VisitPathEdges(graph_, to, visitor);
+    return tree.weights[to];
+}
+
+template <typename Weight, typename Queue>
+const typename LazyRouter<Weight, Queue>::Tree& LazyRouter<Weight, Queue>::GetTree(VertexId from) const {
+    if (const auto it = rows_.find(from); it != rows_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.first);
+        return it->second.second;
+    }
+
+    if (rows_.size() >= max_rows_) {
+        rows_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    lru_.push_front(from);
+    return rows_.emplace(from, std::make_pair(lru_.begin(), BuildShortestPathTree(graph_, from, std::optional<Weight>(), std::optional<VertexId>(), AllEdges{}, queue_))).first->second.second;
+}
+
+}  // namespace graph
@@ -5,6 +5,7 @@
 #include "map_renderer.h"
 #include "request_handler.h"
 #include "serialization.h"
+#include "flat_base.h"
 
 using namespace std;
 using namespace transport_catalogue;
@@ -13,6 +14,7 @@ using namespace request_handler;
 
 using namespace transport_catalogue::detail::json;
 using namespace transport_catalogue::detail::router;
+using namespace transport_catalogue::detail::spatial;
 
 using namespace serialization;
 
@@ -48,8 +50,38 @@ int main(int argc, char* argv[]) {
             routing_settings,
             serialization_settings);
 
+        SpatialIndex spatial_index(transport_catalogue.GetStops());
+
+        // Пешие пересадки ищутся по пространственному индексу и входят в граф до всех расчётов по нему
+        StopWalks stop_walks;
+        for (const auto& pair : spatial_index.FindPairsWithin(routing_settings.walking_radius)) {
+            stop_walks.push_back({ pair.first_id, pair.second_id, pair.distance });
+        }
+
+        // Компоненты связности считаются по графу маршрутизации один раз и хранятся в базе
+        TransportRouter transport_router;
+        transport_router.SetRoutingSettings(routing_settings);
+        transport_router.SetStopWalks(stop_walks);
+        transport_router.SetGraph(transport_catalogue);
+        StopComponents stop_components = transport_router.ComputeStopComponents(transport_catalogue);
+
+        StopHubLabels stop_hub_labels;
+        if (routing_settings.hub_labels) {
+            stop_hub_labels = transport_router.ComputeStopHubLabels(transport_catalogue);
+        }
+
+        StopArcFlags stop_arc_flags;
+        if (routing_settings.router_mode == RouterMode::ARC_FLAGS) {
+            stop_arc_flags = transport_router.ComputeStopArcFlags(transport_catalogue);
+        }
+
+        // Таблица всех пар не хранится в базе: она пишется отдельным файлом и отображается в память при запросах
+        if (routing_settings.router_mode == RouterMode::ALL_PAIRS && !routing_settings.route_table_file.empty()) {
+            transport_router.WriteRouteTable();
+        }
+
         ofstream out_file(serialization_settings.file_name, ios::binary);
-        CatalogueSerialization(transport_catalogue, render_settings, routing_settings, out_file);
+        CatalogueSerialization(transport_catalogue, render_settings, routing_settings, spatial_index, stop_components, stop_hub_labels, stop_arc_flags, stop_walks, serialization_settings, out_file);
 
     }
     else if (mode == "process_requests"sv) {
@@ -58,15 +90,32 @@ int main(int argc, char* argv[]) {
 
         json_reader.ParseNodeProcessRequests(stat_request, serialization_settings);
 
-        ifstream in_file(serialization_settings.file_name, ios::binary);
-        Catalogue catalogue = CatalogueDeserialization(in_file);
-
         RequestHandler request_handler;
 
-        request_handler.ExecuteQueries(catalogue.transport_catalogue_,
-            stat_request,
-            catalogue.render_settings_,
-            catalogue.routing_settings_);
+        // Плоская база отображается в память: запросы Bus и Stop читают её на месте, для остальных она загружается целиком
+        optional<FlatBase> flat_base;
+        if (FlatBase::IsFlatBase(serialization_settings.file_name)) {
+            flat_base.emplace(serialization_settings.file_name);
+        }
+
+        if (flat_base && request_handler.CanExecuteInPlace(stat_request)) {
+            request_handler.ExecuteQueries(*flat_base, stat_request);
+        }
+        else {
+            ifstream in_file(serialization_settings.file_name, ios::binary);
+            Catalogue catalogue = flat_base ? flat_base->LoadCatalogue() : CatalogueDeserialization(in_file);
+            json_reader.ParseNodeRoutingOverride(catalogue.routing_settings_);
+
+            request_handler.ExecuteQueries(catalogue.transport_catalogue_,
+                stat_request,
+                catalogue.render_settings_,
+                catalogue.routing_settings_,
+                catalogue.spatial_index_,
+                catalogue.stop_components_,
+                catalogue.stop_hub_labels_,
+                catalogue.stop_arc_flags_,
+                catalogue.stop_walks_);
+        }
 
         Print(request_handler.GetDocument(), cout);
 
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "router.h"
+
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+namespace graph {
+
+// Маршрутизатор, который ищет пути по копии графа с весами другого типа - например, float, чтобы таблицы были вдвое меньше.
+// Рёбра копии имеют те же номера, поэтому найденный путь годится и для исходного графа,
+// а его вес считается по исходным рёбрам и не накапливает ошибку округления
+template <typename Weight, typename SearchWeight>
+class QuantizedRouter : public RouterEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using SearchGraph = DirectedWeightedGraph<SearchWeight>;
+
+public:
+    using RouteInfo = typename RouterEngine<Weight>::RouteInfo;
+    using EdgeVisitor = typename RouterEngine<Weight>::EdgeVisitor;
+    using EngineFactory = std::function<std::unique_ptr<RouterEngine<SearchWeight>>(const SearchGraph&)>;
+
+    // scale - число единиц SearchWeight в единице исходного веса, для целых весов вес округляется
+    QuantizedRouter(const Graph& graph, double scale, const EngineFactory& make_engine);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const override;
+    std::optional<Weight> VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const override;
+
+    static SearchWeight Quantize(Weight weight, double scale);
+
+private:
+    Weight ComputeWeight(const std::vector<EdgeId>& edges) const;
+
+    const Graph& graph_;
+    SearchGraph search_graph_;
+    std::unique_ptr<RouterEngine<SearchWeight>> engine_;
+};
+
+template <typename Weight, typename SearchWeight>
+QuantizedRouter<Weight, SearchWeight>::QuantizedRouter(const Graph& graph, double scale, const EngineFactory& make_engine)
+    : graph_(graph)
+    , search_graph_(graph.GetVertexCount())
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        search_graph_.AddEdge({edge.from, edge.to, Quantize(edge.weight, scale)});
+    }
+    engine_ = make_engine(search_graph_);
+}
+
+template <typename Weight, typename SearchWeight>
+std::optional<typename QuantizedRouter<Weight, SearchWeight>::RouteInfo> QuantizedRouter<Weight, SearchWeight>::BuildRoute(
+    VertexId from, VertexId to) const {
+    auto route = engine_->BuildRoute(from, to);
+    if (!route) {
+        return std::nullopt;
+    }
+    return RouteInfo{ComputeWeight(route->edges), std::move(route->edges)};
+}
+
+template <typename Weight, typename SearchWeight>
+std::optional<Weight> QuantizedRouter<Weight, SearchWeight>::GetRouteWeight(VertexId from, VertexId to) const {
+    // Точный вес известен только по рёбрам пути, поэтому путь обходится
+    return VisitRoute(from, to, [](EdgeId) {});
+}
+
+// Рёбра передаются дальше по мере обхода, вес складывается по исходным рёбрам
+template <typename Weight, typename SearchWeight>
+std::optional<Weight> QuantizedRouter<Weight, SearchWeight>::VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const {
+    // Состояние захватывается одним указателем, чтобы лямбда помещалась в std::function без выделения памяти
+    struct State {
+        const Graph& graph;
+        const EdgeVisitor& visitor;
+        Weight weight{};
+    } state{graph_, visitor};
+
+    const auto found = engine_->VisitRoute(from, to, [&state](EdgeId edge_id) {
+        state.weight += state.graph.GetEdge(edge_id).weight;
+        state.visitor(edge_id);
+    });
+    if (!found) {
+        return std::nullopt;
+    }
+    return state.weight;
+}
+
+template <typename Weight, typename SearchWeight>
+SearchWeight QuantizedRouter<Weight, SearchWeight>::Quantize(Weight weight, double scale) {
+    if constexpr (std::is_integral_v<SearchWeight>) {
+        return static_cast<SearchWeight>(std::llround(weight * scale));
+    } else {
+        return static_cast<SearchWeight>(weight * scale);
+    }
+}
+
+template <typename Weight, typename SearchWeight>
+Weight QuantizedRouter<Weight, SearchWeight>::ComputeWeight(const std::vector<EdgeId>& edges) const {
+    Weight weight{};
+    for (const EdgeId edge_id : edges) {
+        weight += graph_.GetEdge(edge_id).weight;
+    }
+    return weight;
+}
+
+}  // namespace graph
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Монотонная очередь с приоритетом для целых беззнаковых ключей (radix heap).
+// Извлекаемые ключи не убывают, а добавлять можно только ключи не меньше последнего извлечённого -
+// этого достаточно для алгоритма Дейкстры с неотрицательными весами.
+// Элемент перекладывается между корзинами не больше чем число бит ключа раз
+template <typename Key, typename Value>
+class RadixHeap {
+    static_assert(std::is_unsigned_v<Key>, "RadixHeap keys should be unsigned integers");
+
+public:
+    void Push(Key key, Value value) {
+        assert(key >= last_);
+        buckets_[GetBucket(key)].push_back({key, std::move(value)});
+        ++size_;
+    }
+
+    std::pair<Key, Value> Pop() {
+        assert(size_ > 0);
+        Refill();
+
+        auto result = std::move(buckets_[0].back());
+        buckets_[0].pop_back();
+        --size_;
+        return result;
+    }
+
+    // Все элементы с наименьшим ключом дописываются в items, возвращается этот ключ.
+    // Нужно, когда элементы одного ключа извлекаются в своём порядке
+    Key PopMinKey(std::vector<std::pair<Key, Value>>& items) {
+        assert(size_ > 0);
+        Refill();
+
+        auto& bucket = buckets_[0];
+        size_ -= bucket.size();
+        std::move(bucket.begin(), bucket.end(), std::back_inserter(items));
+        bucket.clear();
+        return last_;
+    }
+
+    bool IsEmpty() const {
+        return size_ == 0;
+    }
+
+private:
+    static constexpr size_t BUCKET_COUNT = std::numeric_limits<Key>::digits + 1;
+
+    // Если в корзине наименьшего ключа пусто, новый минимум берётся из первой непустой корзины,
+    // её элементы расходятся по младшим корзинам
+    void Refill() {
+        if (!buckets_[0].empty()) {
+            return;
+        }
+        size_t index = 1;
+        while (buckets_[index].empty()) {
+            ++index;
+        }
+
+        auto& bucket = buckets_[index];
+        last_ = bucket.front().first;
+        for (const auto& item : bucket) {
+            last_ = std::min(last_, item.first);
+        }
+        for (auto& item : bucket) {
+            buckets_[GetBucket(item.first)].push_back(std::move(item));
+        }
+        bucket.clear();
+    }
+
+    // Номер старшего бита, в котором ключ отличается от последнего извлечённого
+    size_t GetBucket(Key key) const {
+        const Key diff = key ^ last_;
+#ifdef __GNUC__
+        return diff == 0 ? 0 : std::numeric_limits<unsigned long long>::digits - __builtin_clzll(diff);
+#else
+        size_t bucket = 0;
+        for (Key rest = diff; rest != 0; rest >>= 1) {
+            ++bucket;
+        }
+        return bucket;
+#endif
+    }
+
+    std::array<std::vector<std::pair<Key, Value>>, BUCKET_COUNT> buckets_;
+    Key last_ = 0;
+    size_t size_ = 0;
+};
+
+}  // namespace graph
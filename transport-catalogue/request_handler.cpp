@@ -26,9 +26,41 @@ namespace request_handler {
                 .EndDict()
                 .Build();
         }
+
+        Node operator()(const WalkEdge& edge_info) {
+            return Builder{}.StartDict()
+                .Key("type").Value("Walk")
+                .Key("from").Value(std::string(edge_info.from))
+                .Key("to").Value(std::string(edge_info.to))
+                .Key("time").Value(edge_info.time)
+                .EndDict()
+                .Build();
+        }
     };
-    std::optional<RouteInfo> RequestHandler::GetRouteInfo(std::string_view start, std::string_view end, TransportCatalogue& catalogue, TransportRouter& routing) const {
-        return routing.GetRouteInfo(routing.GetRouterByStop(catalogue.FindStop(start))->bus_wait_start, routing.GetRouterByStop(catalogue.FindStop(end))->bus_wait_start);
+    Array MakeRouteItems(const RouteInfo& route_info) {
+        Array items;
+        for (const auto& item : route_info.edges) {
+            items.emplace_back(std::visit(EdgeInfoGetter{}, item));
+        }
+        return items;
+    }
+
+    std::optional<RouteInfo> RequestHandler::GetRouteInfo(std::string_view start, std::string_view end, TransportCatalogue& catalogue, TransportRouter& routing, std::string_view profile) const {
+        return routing.GetRouteInfo(routing.GetRouterByStop(catalogue.FindStop(start))->bus_wait_start, routing.GetRouterByStop(catalogue.FindStop(end))->bus_wait_start, profile);
+    }
+    RouteMatrix RequestHandler::GetRouteMatrix(const std::vector<std::string>& starts, const std::vector<std::string>& ends, TransportCatalogue& catalogue, TransportRouter& routing) const {
+        // Неизвестные остановки дают пустые строки и столбцы матрицы
+        auto to_vertexes = [&catalogue, &routing](const std::vector<std::string>& names) {
+            std::vector<std::optional<VertexId>> vertexes;
+
+            for (const auto& name : names) {
+                const auto router_by_stop = routing.GetRouterByStop(catalogue.FindStop(name));
+                vertexes.push_back(router_by_stop ? std::optional<VertexId>(router_by_stop->bus_wait_start) : std::nullopt);
+            }
+            return vertexes;
+        };
+
+        return routing.GetRouteMatrix(to_vertexes(starts), to_vertexes(ends));
     }
     std::vector<detail::geo::Coordinates> RequestHandler::GetStopsCoordinates(TransportCatalogue& catalogue) const {
         std::vector <detail::geo::Coordinates> stops_coordinates;
@@ -71,7 +103,7 @@ namespace request_handler {
             bus_info.stops_on_route = static_cast<int>(bus->stops_bus.size());
             bus_info.unique_stops = static_cast<int>(catalogue.GetUniqStops(bus).size());
             bus_info.route_length = static_cast<int>(bus->route_length);
-            bus_info.curvature = double(catalogue.GetDistanceBus(bus) / catalogue.GetComputeDistance(bus));
+            bus_info.curvature = double(bus->route_length / bus->geo_length);
         } else {
             bus_info.name = text;
             bus_info.not_found = true;
@@ -102,6 +134,77 @@ namespace request_handler {
         return stop_info;
     }
 
+    // Ответы Bus и Stop по плоской базе берутся из записей как есть, справочник не строится
+    BusQuery RequestHandler::QueryBus(const serialization::FlatBase& base, std::string_view text) {
+        BusQuery bus_info;
+        const auto bus_id = base.FindBus(text);
+
+        if (bus_id) {
+            const serialization::FlatBus& bus = base.GetBus(*bus_id);
+
+            bus_info.name = base.GetName(bus.name);
+            bus_info.not_found = false;
+            bus_info.stops_on_route = static_cast<int>(bus.stops_count);
+            bus_info.unique_stops = static_cast<int>(bus.unique_stops);
+            bus_info.route_length = static_cast<int>(bus.route_length);
+            bus_info.curvature = double(bus.route_length / bus.geo_length);
+        } else {
+            bus_info.name = text;
+            bus_info.not_found = true;
+        }
+        return bus_info;
+    }
+    StopQuery RequestHandler::QueryStop(const serialization::FlatBase& base, std::string_view text) {
+        StopQuery stop_info;
+        const auto stop_id = base.FindStop(text);
+
+        if (stop_id) {
+            const serialization::FlatStop& stop = base.GetStop(*stop_id);
+
+            stop_info.name = base.GetName(stop.name);
+            stop_info.not_found = false;
+
+            for (const uint32_t bus_id : base.GetStopBuses(stop)) {
+                stop_info.buses_name.emplace_back(base.GetName(base.GetBus(bus_id).name));
+            }
+        } else {
+            stop_info.name = text;
+            stop_info.not_found = true;
+        }
+        return stop_info;
+    }
+
+    NearestStopsQuery RequestHandler::QueryNearestStops(TransportCatalogue& catalogue, const SpatialIndex& spatial_index, detail::geo::Coordinates point, int count) {
+        NearestStopsQuery nearest_info;
+
+        if (count <= 0) {
+            return nearest_info;
+        }
+
+        for (const auto& nearest : spatial_index.FindNearest(point, static_cast<size_t>(count))) {
+            const Stop* stop = catalogue.GetStopById(nearest.stop_id);
+
+            // Индекс ранжирует по сжатым координатам, в ответ идёт точное расстояние
+            if (stop) {
+                nearest_info.stops.push_back({ stop->name_stop, detail::geo::ComputeDistance(point, { stop->latitude, stop->longitude }) });
+            }
+        }
+        return nearest_info;
+    }
+    StopsInBBoxQuery RequestHandler::QueryStopsInBBox(TransportCatalogue& catalogue, const SpatialIndex& spatial_index, detail::geo::Coordinates min, detail::geo::Coordinates max) {
+        StopsInBBoxQuery bbox_info;
+
+        for (uint32_t stop_id : spatial_index.FindInBox(min, max)) {
+            const Stop* stop = catalogue.GetStopById(stop_id);
+
+            if (stop) {
+                bbox_info.stops.push_back(stop->name_stop);
+            }
+        }
+        std::sort(bbox_info.stops.begin(), bbox_info.stops.end());
+        return bbox_info;
+    }
+
     Node RequestHandler::ExecuteMakeNodeStop(int id_request, const StopQuery& stop_query) {
         Node result;
         Array buses;
@@ -170,11 +273,74 @@ namespace request_handler {
 
         return result;
     }
-    void RequestHandler::ExecuteQueries(TransportCatalogue& catalogue, std::vector<StatRequest>& stat_requests, RenderSettings& render_settings, RoutingSettings& routing_settings) {
+    Node RequestHandler::ExecuteMakeNodeNearestStops(int id_request, const NearestStopsQuery& nearest_query) {
+        Builder builder;
+
+        builder.StartDict()
+            .Key("request_id").Value(id_request)
+            .Key("stops").StartArray();
+
+        for (const auto& [stop_name, distance] : nearest_query.stops) {
+            builder.StartDict()
+                .Key("name").Value(std::string(stop_name))
+                .Key("distance").Value(distance)
+                .EndDict();
+        }
+        builder.EndArray().EndDict();
+
+        return builder.Build();
+    }
+    Node RequestHandler::ExecuteMakeNodeRouteCacheStats(int id_request, const RouteCacheStats& stats) {
+        return Builder{}.StartDict()
+            .Key("request_id").Value(id_request)
+            .Key("hits").Value(static_cast<int>(stats.hits))
+            .Key("misses").Value(static_cast<int>(stats.misses))
+            .Key("evictions").Value(static_cast<int>(stats.evictions))
+            .Key("size").Value(static_cast<int>(stats.size))
+            .EndDict()
+            .Build();
+    }
+    Node RequestHandler::ExecuteMakeNodeStopsInBBox(int id_request, const StopsInBBoxQuery& bbox_query) {
+        Builder builder;
+
+        builder.StartDict()
+            .Key("request_id").Value(id_request)
+            .Key("stops").StartArray();
+
+        for (std::string_view stop_name : bbox_query.stops) {
+            builder.Value(std::string(stop_name));
+        }
+        builder.EndArray().EndDict();
+
+        return builder.Build();
+    }
+    // Только Bus и Stop отвечаются по отображённой базе без загрузки, остальным нужен маршрутизатор или весь справочник
+    bool RequestHandler::CanExecuteInPlace(const std::vector<StatRequest>& stat_requests) const {
+        return std::all_of(stat_requests.begin(), stat_requests.end(), [](const StatRequest& req) {
+            return req.type == "Stop" || req.type == "Bus";
+        });
+    }
+    void RequestHandler::ExecuteQueries(const serialization::FlatBase& base, std::vector<StatRequest>& stat_requests) {
+        std::vector<Node> result_request;
+
+        for (const StatRequest& req : stat_requests) {
+            if (req.type == "Stop") {
+                result_request.push_back(ExecuteMakeNodeStop(req.id, QueryStop(base, req.name)));
+            } else if (req.type == "Bus") {
+                result_request.push_back(ExecuteMakeNodeBus(req.id, QueryBus(base, req.name)));
+            }
+        }
+        document_out_ = Document{ Node(result_request) };
+    }
+    void RequestHandler::ExecuteQueries(TransportCatalogue& catalogue, std::vector<StatRequest>& stat_requests, RenderSettings& render_settings, RoutingSettings& routing_settings, const SpatialIndex& spatial_index, const StopComponents& stop_components, const StopHubLabels& stop_hub_labels, const StopArcFlags& stop_arc_flags, const StopWalks& stop_walks) {
         std::vector<Node> result_request;
         TransportRouter routing;
 
         routing.SetRoutingSettings(routing_settings);
+        routing.SetStopComponents(stop_components);
+        routing.SetStopHubLabels(stop_hub_labels);
+        routing.SetStopArcFlags(stop_arc_flags);
+        routing.SetStopWalks(stop_walks);
         routing.BuildRouter(catalogue);
 
         for (StatRequest req : stat_requests) {
@@ -186,6 +352,16 @@ namespace request_handler {
                 result_request.push_back(ExecuteMakeNodeMap(req.id, catalogue, render_settings));
             } else if (req.type == "Route") {
                 result_request.push_back(ExecuteMakeNodeRoute(req, catalogue, routing));
+            } else if (req.type == "Isochrone") {
+                result_request.push_back(ExecuteMakeNodeIsochrone(req, catalogue, routing));
+            } else if (req.type == "RouteMatrix") {
+                result_request.push_back(ExecuteMakeNodeRouteMatrix(req, catalogue, routing));
+            } else if (req.type == "NearestStops") {
+                result_request.push_back(ExecuteMakeNodeNearestStops(req.id, QueryNearestStops(catalogue, spatial_index, req.coordinates, req.count)));
+            } else if (req.type == "StopsInBBox") {
+                result_request.push_back(ExecuteMakeNodeStopsInBBox(req.id, QueryStopsInBBox(catalogue, spatial_index, req.min_coordinates, req.max_coordinates)));
+            } else if (req.type == "RouteCacheStats") {
+                result_request.push_back(ExecuteMakeNodeRouteCacheStats(req.id, routing.GetRouteCacheStats()));
             }
         }
         document_out_ = Document{ Node(result_request) };
@@ -252,26 +428,136 @@ namespace request_handler {
     }
 
     Node RequestHandler::ExecuteMakeNodeRoute(StatRequest& request, TransportCatalogue& catalogue, TransportRouter& routing) {
-        const auto& route_info = GetRouteInfo(request.from, request.to, catalogue, routing);
-
-        if (!route_info) {
+        // Без маршрута по участкам нужен только вес пути - его дают метки хабов
+        if (!request.itinerary) {
+            const auto total_time = routing.GetRouteTime(routing.GetRouterByStop(catalogue.FindStop(request.from))->bus_wait_start,
+                                                         routing.GetRouterByStop(catalogue.FindStop(request.to))->bus_wait_start,
+                                                         request.profile);
+            if (!total_time) {
+                return Builder{}.StartDict()
+                    .Key("request_id").Value(request.id)
+                    .Key("error_message").Value("not found")
+                    .EndDict()
+                    .Build();
+            }
             return Builder{}.StartDict()
                 .Key("request_id").Value(request.id)
-                .Key("error_message").Value("not found")
+                .Key("total_time").Value(*total_time)
                 .EndDict()
                 .Build();
         }
 
+        const auto start = routing.GetRouterByStop(catalogue.FindStop(request.from))->bus_wait_start;
+        const auto end = routing.GetRouterByStop(catalogue.FindStop(request.to))->bus_wait_start;
+
+        if (request.alternatives > 1) {
+            return ExecuteMakeNodeAlternativeRoutes(request, start, end, routing);
+        }
+
+        // Участки маршрута сразу становятся элементами ответа, без промежуточных векторов рёбер и участков
         Array items;
-        for (const auto& item : route_info->edges) {
+        const auto total_time = routing.VisitRoute(start, end, request.profile, [&items](const std::variant<StopEdge, BusEdge, WalkEdge>& item) {
             items.emplace_back(std::visit(EdgeInfoGetter{}, item));
+        });
+
+        if (!total_time) {
+            return Builder{}.StartDict()
+                .Key("request_id").Value(request.id)
+                .Key("error_message").Value("not found")
+                .EndDict()
+                .Build();
         }
 
         return Builder{}.StartDict()
             .Key("request_id").Value(request.id)
-            .Key("total_time").Value(route_info->total_time)
-            .Key("items").Value(items)
+            .Key("total_time").Value(*total_time)
+            .Key("items").Value(std::move(items))
             .EndDict()
             .Build();
     }
+
+    // Кратчайший маршрут ищется один раз - внутри поиска альтернатив, и он же становится основным ответом.
+    // Остальные маршруты идут в alternatives по возрастанию времени
+    Node RequestHandler::ExecuteMakeNodeAlternativeRoutes(StatRequest& request, VertexId start, VertexId end, TransportRouter& routing) {
+        const auto routes = routing.GetAlternativeRoutes(start, end, static_cast<size_t>(request.alternatives), request.profile);
+
+        if (routes.empty()) {
+            return Builder{}.StartDict()
+                .Key("request_id").Value(request.id)
+                .Key("error_message").Value("not found")
+                .EndDict()
+                .Build();
+        }
+
+        Builder builder;
+        builder.StartDict()
+            .Key("request_id").Value(request.id)
+            .Key("total_time").Value(routes.front().total_time)
+            .Key("items").Value(MakeRouteItems(routes.front()))
+            .Key("alternatives").StartArray();
+
+        for (size_t i = 1; i < routes.size(); ++i) {
+            builder.StartDict()
+                .Key("total_time").Value(routes[i].total_time)
+                .Key("items").Value(MakeRouteItems(routes[i]))
+                .EndDict();
+        }
+        builder.EndArray().EndDict();
+
+        return builder.Build();
+    }
+
+    Node RequestHandler::ExecuteMakeNodeIsochrone(StatRequest& request, TransportCatalogue& catalogue, TransportRouter& routing) {
+        const auto router_by_stop = routing.GetRouterByStop(catalogue.FindStop(request.from));
+        const auto reachable_stops = router_by_stop
+            ? routing.GetReachableStops(router_by_stop->bus_wait_start, request.max_time, request.profile)
+            : std::nullopt;
+
+        if (!reachable_stops) {
+            return Builder{}.StartDict()
+                .Key("request_id").Value(request.id)
+                .Key("error_message").Value("not found")
+                .EndDict()
+                .Build();
+        }
+
+        Builder builder;
+        builder.StartDict()
+            .Key("request_id").Value(request.id)
+            .Key("stops").StartArray();
+
+        for (const auto& reachable : *reachable_stops) {
+            builder.StartDict()
+                .Key("stop_name").Value(std::string(reachable.name))
+                .Key("time").Value(reachable.time)
+                .EndDict();
+        }
+        builder.EndArray().EndDict();
+
+        return builder.Build();
+    }
+
+    Node RequestHandler::ExecuteMakeNodeRouteMatrix(StatRequest& request, TransportCatalogue& catalogue, TransportRouter& routing) {
+        Builder builder;
+
+        builder.StartDict()
+            .Key("request_id").Value(request.id)
+            .Key("times").StartArray();
+
+        // Недостижимые пары выводятся как null
+        for (const auto& row : GetRouteMatrix(request.from_stops, request.to_stops, catalogue, routing)) {
+            builder.StartArray();
+            for (const auto& time : row) {
+                if (time) {
+                    builder.Value(*time);
+                } else {
+                    builder.Value(nullptr);
+                }
+            }
+            builder.EndArray();
+        }
+        builder.EndArray().EndDict();
+
+        return builder.Build();
+    }
 }
\ No newline at end of file
@@ -5,11 +5,14 @@
 #include "transport_catalogue.h"
 #include "json_builder.h"
 #include "transport_router.h"
+#include "spatial_index.h"
+#include "flat_base.h"
 
 using namespace transport_catalogue;
 using namespace detail;
 using namespace transport_catalogue::detail::json;
 using namespace transport_catalogue::detail::router;
+using namespace transport_catalogue::detail::spatial;
 using namespace map_renderer;
 
 namespace request_handler {
@@ -18,20 +21,33 @@ namespace request_handler {
     public:
         RequestHandler() = default;
 
-        std::optional<RouteInfo> GetRouteInfo(std::string_view start, std::string_view end, TransportCatalogue& catalogue, TransportRouter& routing) const;
+        std::optional<RouteInfo> GetRouteInfo(std::string_view start, std::string_view end, TransportCatalogue& catalogue, TransportRouter& routing, std::string_view profile = {}) const;
+        RouteMatrix GetRouteMatrix(const std::vector<std::string>& starts, const std::vector<std::string>& ends, TransportCatalogue& catalogue, TransportRouter& routing) const;
 
         std::vector<detail::geo::Coordinates> GetStopsCoordinates(TransportCatalogue& catalogue) const;
         std::vector<std::string_view> GetSortBusesNames(TransportCatalogue& catalogue) const;
 
         BusQuery QueryBus(TransportCatalogue& catalogue, std::string_view text);
         StopQuery QueryStop(TransportCatalogue& catalogue, std::string_view text);
+        BusQuery QueryBus(const serialization::FlatBase& base, std::string_view text);
+        StopQuery QueryStop(const serialization::FlatBase& base, std::string_view text);
+        NearestStopsQuery QueryNearestStops(TransportCatalogue& catalogue, const SpatialIndex& spatial_index, detail::geo::Coordinates point, int count);
+        StopsInBBoxQuery QueryStopsInBBox(TransportCatalogue& catalogue, const SpatialIndex& spatial_index, detail::geo::Coordinates min, detail::geo::Coordinates max);
 
         Node ExecuteMakeNodeStop(int id_request, const StopQuery& stop_query);
         Node ExecuteMakeNodeBus(int id_request, const BusQuery& bus_query);
         Node ExecuteMakeNodeMap(int id_request, TransportCatalogue& catalogue, RenderSettings render_settings);
-        void ExecuteQueries(TransportCatalogue& catalogue, std::vector<StatRequest>& stat_requests, RenderSettings& render_settings, RoutingSettings& routing_settings);
+        Node ExecuteMakeNodeNearestStops(int id_request, const NearestStopsQuery& nearest_query);
+        Node ExecuteMakeNodeStopsInBBox(int id_request, const StopsInBBoxQuery& bbox_query);
+        Node ExecuteMakeNodeRouteCacheStats(int id_request, const RouteCacheStats& stats);
+        bool CanExecuteInPlace(const std::vector<StatRequest>& stat_requests) const;
+        void ExecuteQueries(const serialization::FlatBase& base, std::vector<StatRequest>& stat_requests);
+        void ExecuteQueries(TransportCatalogue& catalogue, std::vector<StatRequest>& stat_requests, RenderSettings& render_settings, RoutingSettings& routing_settings, const SpatialIndex& spatial_index, const StopComponents& stop_components, const StopHubLabels& stop_hub_labels, const StopArcFlags& stop_arc_flags, const StopWalks& stop_walks);
         void ExecuteRenderMap(MapRenderer& map_catalogue, TransportCatalogue& catalogue) const;
         Node ExecuteMakeNodeRoute(StatRequest& request, TransportCatalogue& catalogue, TransportRouter& routing);
+        Node ExecuteMakeNodeAlternativeRoutes(StatRequest& request, VertexId start, VertexId end, TransportRouter& routing);
+        Node ExecuteMakeNodeIsochrone(StatRequest& request, TransportCatalogue& catalogue, TransportRouter& routing);
+        Node ExecuteMakeNodeRouteMatrix(StatRequest& request, TransportCatalogue& catalogue, TransportRouter& routing);
 
         const Document& GetDocument();
 
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "router.h"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace graph {
+
+const size_t ROUTE_CACHE_SHARDS = 16;
+
+// Счётчики кеша маршрутов
+struct RouteCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+};
+
+// Кеш готовых маршрутов перед другим маршрутизатором, ключ - пара вершин.
+// Маршрут хранится компактно: вес и номера рёбер в uint32_t; недостижимость тоже запоминается.
+// Кеш разбит на шарды со своими мьютексами и LRU-вытеснением: читатели разных шардов не мешают друг другу,
+// а попадание отдаёт маршрут по shared_ptr без копирования рёбер под блокировкой.
+// Промахи идут во внутренний маршрутизатор; если тот меняет своё состояние в const-методах (LazyRouter),
+// serialize_misses пропускает к нему промахи по одному, а попадания по-прежнему отдаются параллельно
+template <typename Weight>
+class CachedRouter : public RouterEngine<Weight> {
+public:
+    using RouteInfo = typename RouterEngine<Weight>::RouteInfo;
+    using EdgeVisitor = typename RouterEngine<Weight>::EdgeVisitor;
+
+    // capacity - наибольшее число маршрутов во всём кеше, округляется вверх до кратного числу шардов
+    CachedRouter(std::unique_ptr<RouterEngine<Weight>> engine, size_t vertex_count, size_t capacity, bool serialize_misses = false);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const override;
+    std::optional<Weight> VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const override;
+
+    RouteCacheStats GetStats() const;
+
+private:
+    struct CachedRoute {
+        std::optional<Weight> weight;
+        std::vector<uint32_t> edges;
+    };
+    using CachedRoutePtr = std::shared_ptr<const CachedRoute>;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<uint64_t> lru;    // в начале - последние использованные
+        std::unordered_map<uint64_t, std::pair<std::list<uint64_t>::iterator, CachedRoutePtr>> routes;
+    };
+
+    uint64_t MakeKey(VertexId from, VertexId to) const;
+    Shard& GetShard(uint64_t key) const;
+    CachedRoutePtr Find(uint64_t key) const;
+    void Insert(uint64_t key, CachedRoutePtr route) const;
+
+    std::unique_ptr<RouterEngine<Weight>> engine_;
+    size_t vertex_count_;
+    size_t shard_capacity_;
+    bool serialize_misses_;
+
+    mutable std::mutex engine_mutex_;
+    mutable std::vector<Shard> shards_;
+    mutable std::atomic<uint64_t> hits_ = 0;
+    mutable std::atomic<uint64_t> misses_ = 0;
+    mutable std::atomic<uint64_t> evictions_ = 0;
+};
+
+template <typename Weight>
+CachedRouter<Weight>::CachedRouter(std::unique_ptr<RouterEngine<Weight>> engine, size_t vertex_count, size_t capacity, bool serialize_misses)
+    : engine_(std::move(engine))
+    , vertex_count_(vertex_count)
+    , shard_capacity_(std::max<size_t>((capacity + ROUTE_CACHE_SHARDS - 1) / ROUTE_CACHE_SHARDS, 1))
+    , serialize_misses_(serialize_misses)
+    , shards_(ROUTE_CACHE_SHARDS)
+{
+}
+
+template <typename Weight>
+std::optional<typename CachedRouter<Weight>::RouteInfo> CachedRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    std::vector<EdgeId> edges;
+    const auto weight = VisitRoute(from, to, [&edges](EdgeId edge_id) { edges.push_back(edge_id); });
+    if (!weight) {
+        return std::nullopt;
+    }
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+// Только вес не кладётся в кеш при промахе: пути для него не восстанавливаются
+template <typename Weight>
+std::optional<Weight> CachedRouter<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+    if (const auto route = Find(MakeKey(from, to))) {
+        return route->weight;
+    }
+
+    std::unique_lock guard(engine_mutex_, std::defer_lock);
+    if (serialize_misses_) {
+        guard.lock();
+    }
+    return engine_->GetRouteWeight(from, to);
+}
+
+template <typename Weight>
+std::optional<Weight> CachedRouter<Weight>::VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const {
+    const uint64_t key = MakeKey(from, to);
+
+    if (const auto route = Find(key)) {
+        for (const uint32_t edge_id : route->edges) {
+            visitor(edge_id);
+        }
+        return route->weight;
+    }
+
+    auto route = std::make_shared<CachedRoute>();
+    {
+        std::unique_lock guard(engine_mutex_, std::defer_lock);
+        if (serialize_misses_) {
+            guard.lock();
+        }
+        route->weight = engine_->VisitRoute(from, to, [&route](EdgeId edge_id) { route->edges.push_back(static_cast<uint32_t>(edge_id)); });
+    }
+    route->edges.shrink_to_fit();
+
+    for (const uint32_t edge_id : route->edges) {
+        visitor(edge_id);
+    }
+
+    const auto weight = route->weight;
+    Insert(key, std::move(route));
+    return weight;
+}
+
+template <typename Weight>
+RouteCacheStats CachedRouter<Weight>::GetStats() const {
+    RouteCacheStats stats{hits_, misses_, evictions_, 0};
+
+    for (const Shard& shard : shards_) {
+        std::lock_guard guard(shard.mutex);
+        stats.size += shard.routes.size();
+    }
+    return stats;
+}
+
+template <typename Weight>
+uint64_t CachedRouter<Weight>::MakeKey(VertexId from, VertexId to) const {
+    return static_cast<uint64_t>(from) * vertex_count_ + to;
+}
+
+// Соседние ключи перемешиваются, чтобы одна строка запросов не попадала в один шард
+template <typename Weight>
+typename CachedRouter<Weight>::Shard& CachedRouter<Weight>::GetShard(uint64_t key) const {
+    return shards_[(key * 0x9E3779B97F4A7C15ull) >> 60 & (ROUTE_CACHE_SHARDS - 1)];
+}
+
+template <typename Weight>
+typename CachedRouter<Weight>::CachedRoutePtr CachedRouter<Weight>::Find(uint64_t key) const {
+    Shard& shard = GetShard(key);
+    std::lock_guard guard(shard.mutex);
+
+    const auto it = shard.routes.find(key);
+    if (it == shard.routes.end()) {
+        ++misses_;
+        return nullptr;
+    }
+
+    ++hits_;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second.first);
+    return it->second.second;
+}
+
+template <typename Weight>
+void CachedRouter<Weight>::Insert(uint64_t key, CachedRoutePtr route) const {
+    Shard& shard = GetShard(key);
+    std::lock_guard guard(shard.mutex);
+
+    // Другой поток мог успеть положить тот же маршрут
+    if (shard.routes.count(key)) {
+        return;
+    }
+
+    if (shard.routes.size() >= shard_capacity_) {
+        shard.routes.erase(shard.lru.back());
+        shard.lru.pop_back();
+        ++evictions_;
+    }
+    shard.lru.push_front(key);
+    shard.routes.emplace(key, std::make_pair(shard.lru.begin(), std::move(route)));
+}
+
+}  // namespace graph
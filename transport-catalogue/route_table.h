@@ -0,0 +1,341 @@
+#pragma once
+
+#include "dijkstra.h"
+#include "router.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+namespace graph {
+
+const std::array<char, 4> ROUTE_TABLE_MAGIC = {'T', 'C', 'R', 'T'};
+const uint32_t ROUTE_TABLE_VERSION = 1;
+// Строки начинаются с границы страницы, чтобы строка не делила страницу с заголовком
+const uint64_t ROUTE_TABLE_DATA_OFFSET = 4096;
+const size_t ROUTE_TABLE_ROWS_PER_TASK = 64;
+
+// Заголовок файла таблицы всех пар. Хеш графа привязывает таблицу к рёбрам и весам, по которым она построена
+struct RouteTableHeader {
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t weight_size;
+    uint32_t reserved;
+    uint64_t vertex_count;
+    uint64_t edge_count;
+    uint64_t graph_hash;
+};
+
+// Ячейка (from, to) - вес пути и его последнее ребро, как в таблице Router
+template <typename Weight>
+struct RouteTableCell {
+    Weight weight;
+    uint32_t prev_edge;
+};
+
+// FNV-1a по концам и весам рёбер в порядке номеров
+template <typename Weight>
+uint64_t ComputeGraphHash(const DirectedWeightedGraph<Weight>& graph) {
+    static_assert(sizeof(Weight) <= sizeof(uint64_t));
+
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        hash = (hash ^ value) * 1099511628211ull;
+    };
+
+    for (EdgeId id = 0; id < graph.GetEdgeCount(); ++id) {
+        const auto& edge = graph.GetEdge(id);
+        uint64_t weight_bits = 0;
+        std::memcpy(&weight_bits, &edge.weight, sizeof(edge.weight));
+
+        mix(edge.from);
+        mix(edge.to);
+        mix(weight_bits);
+    }
+    return hash;
+}
+
+inline bool ReadRouteTableHeader(const std::string& file_name, RouteTableHeader& header) {
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool success = pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    close(fd);
+    return success && header.magic == ROUTE_TABLE_MAGIC && header.version == ROUTE_TABLE_VERSION;
+}
+
+// Таблица в файле построена по этому графу
+template <typename Weight>
+bool IsRouteTableFor(const std::string& file_name, const DirectedWeightedGraph<Weight>& graph) {
+    RouteTableHeader header;
+    return ReadRouteTableHeader(file_name, header) && header.weight_size == sizeof(Weight)
+        && header.vertex_count == graph.GetVertexCount() && header.edge_count == graph.GetEdgeCount()
+        && header.graph_hash == ComputeGraphHash(graph);
+}
+
+// Хватает ли места на диске для файла размера size. Место старого файла с тем же именем освободится при перезаписи
+inline bool HasDiskSpaceFor(const std::string& file_name, uint64_t size) {
+    const size_t slash = file_name.rfind('/');
+    const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : file_name.substr(0, slash);
+
+    struct statvfs fs_stat {};
+    if (statvfs(directory.c_str(), &fs_stat) != 0) {
+        return false;
+    }
+
+    uint64_t available = static_cast<uint64_t>(fs_stat.f_bavail) * fs_stat.f_frsize;
+    struct stat file_stat {};
+    if (stat(file_name.c_str(), &file_stat) == 0) {
+        available += static_cast<uint64_t>(file_stat.st_blocks) * 512;
+    }
+    return available >= size;
+}
+
+// Таблица всех пар пишется в файл построчно: строка from - дерево Дейкстры от from.
+// В памяти одновременно по строке на поток, а не вся таблица V^2, поэтому файл может быть больше памяти.
+// Потоки берут блоки строк со счётчика и пишут каждую строку на её место в файле.
+// Размер файла V^2 проверяется по свободному месту до перезаписи, недописанный файл удаляется
+template <typename Weight>
+void WriteRouteTable(const DirectedWeightedGraph<Weight>& graph, const std::string& file_name) {
+    using Cell = RouteTableCell<Weight>;
+    constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    const size_t vertex_count = graph.GetVertexCount();
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+
+    const uint64_t row_size = vertex_count * sizeof(Cell);
+    const uint64_t file_size = ROUTE_TABLE_DATA_OFFSET + row_size * vertex_count;
+
+    if (!HasDiskSpaceFor(file_name, file_size)) {
+        throw std::runtime_error("not enough disk space for route table " + file_name + " (" + std::to_string(file_size) + " bytes)");
+    }
+
+    const int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("cannot create route table " + file_name);
+    }
+
+    const RouteTableHeader header{ROUTE_TABLE_MAGIC, ROUTE_TABLE_VERSION, sizeof(Weight), 0,
+                                  vertex_count, graph.GetEdgeCount(), ComputeGraphHash(graph)};
+
+    auto write_at = [fd](const void* data, uint64_t size, uint64_t offset) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            const ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+            if (written <= 0) {
+                return false;
+            }
+            bytes += written;
+            size -= written;
+            offset += written;
+        }
+        return true;
+    };
+
+    std::atomic<bool> failed = ftruncate(fd, static_cast<off_t>(file_size)) != 0
+        || !write_at(&header, sizeof(header), 0);
+    std::atomic<size_t> next_row = 0;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    // Исключение в потоке завершило бы процесс: первое сохраняется и пробрасывается после join
+    auto write_rows = [&]() {
+        try {
+            // Ячейки заполняются по полям, чтобы выравнивание в файле оставалось нулевым
+            std::vector<Cell> row(vertex_count);
+
+            for (size_t begin = next_row.fetch_add(ROUTE_TABLE_ROWS_PER_TASK); begin < vertex_count && !failed;
+                 begin = next_row.fetch_add(ROUTE_TABLE_ROWS_PER_TASK)) {
+                const size_t end = std::min(begin + ROUTE_TABLE_ROWS_PER_TASK, vertex_count);
+
+                for (VertexId from = begin; from < end; ++from) {
+                    const auto tree = BuildShortestPathTree(graph, from);
+
+                    for (VertexId to = 0; to < vertex_count; ++to) {
+                        row[to].weight = tree.weights[to];
+                        row[to].prev_edge = tree.prev_edges[to] == tree.NO_EDGE ? NO_EDGE : static_cast<uint32_t>(tree.prev_edges[to]);
+                    }
+                    if (!write_at(row.data(), row_size, ROUTE_TABLE_DATA_OFFSET + from * row_size)) {
+                        failed = true;
+                    }
+                }
+            }
+        }
+        catch (...) {
+            std::lock_guard lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            failed = true;
+        }
+    };
+
+    const size_t thread_count = std::clamp<size_t>(vertex_count / ROUTE_TABLE_ROWS_PER_TASK, 1, std::max(std::thread::hardware_concurrency(), 1u));
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+
+    // Не запустившийся поток (std::system_error) не прерывает запись: строки дописывают уже запущенные потоки и этот
+    try {
+        for (size_t i = 1; i < thread_count; ++i) {
+            threads.emplace_back(write_rows);
+        }
+    }
+    catch (const std::system_error&) {
+    }
+    write_rows();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const bool closed = close(fd) == 0;
+    if (!closed || failed) {
+        unlink(file_name.c_str());
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        throw std::runtime_error("cannot write route table " + file_name);
+    }
+}
+
+// Таблица всех пар из файла, отображённого в память. Строки читаются по требованию, а страницы
+// кеша ОС общие для всех процессов, открывших ту же таблицу. Маршрут from -> to читает ячейки только строки from.
+// huge_pages - подсказка ОС собирать отображение в большие страницы, если файловая система это умеет
+template <typename Weight>
+class MappedRouter : public RouterEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using Cell = RouteTableCell<Weight>;
+
+public:
+    using RouteInfo = typename RouterEngine<Weight>::RouteInfo;
+    using EdgeVisitor = typename RouterEngine<Weight>::EdgeVisitor;
+
+    MappedRouter(const Graph& graph, const std::string& file_name, bool huge_pages = false);
+    ~MappedRouter();
+
+    MappedRouter(const MappedRouter&) = delete;
+    MappedRouter& operator=(const MappedRouter&) = delete;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const override;
+    std::optional<Weight> VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const override;
+
+private:
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    const Cell& GetCell(VertexId from, VertexId to) const;
+
+    const Graph& graph_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const Cell* cells_ = nullptr;
+};
+
+template <typename Weight>
+MappedRouter<Weight>::MappedRouter(const Graph& graph, const std::string& file_name, bool huge_pages)
+    : graph_(graph)
+{
+    if (!IsRouteTableFor(file_name, graph)) {
+        throw std::invalid_argument("Route table does not match the graph");
+    }
+
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    struct stat file_stat {};
+    const uint64_t vertex_count = graph.GetVertexCount();
+
+    if (fd < 0 || fstat(fd, &file_stat) != 0
+        || static_cast<uint64_t>(file_stat.st_size) != ROUTE_TABLE_DATA_OFFSET + vertex_count * vertex_count * sizeof(Cell)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw std::runtime_error("route table is corrupted");
+    }
+
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("cannot map route table " + file_name);
+    }
+
+    // Запросы к разным строкам независимы: упреждающее чтение соседних страниц не нужно
+    madvise(data, size_, MADV_RANDOM);
+#ifdef MADV_HUGEPAGE
+    if (huge_pages) {
+        madvise(data, size_, MADV_HUGEPAGE);
+    }
+#endif
+
+    data_ = static_cast<const char*>(data);
+    cells_ = reinterpret_cast<const Cell*>(data_ + ROUTE_TABLE_DATA_OFFSET);
+}
+
+template <typename Weight>
+MappedRouter<Weight>::~MappedRouter() {
+    munmap(const_cast<char*>(data_), size_);
+}
+
+template <typename Weight>
+std::optional<typename MappedRouter<Weight>::RouteInfo> MappedRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    std::vector<EdgeId> edges;
+    const auto weight = VisitRoute(from, to, [&edges](EdgeId edge_id) { edges.push_back(edge_id); });
+    if (!weight) {
+        return std::nullopt;
+    }
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<Weight> MappedRouter<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+    const Cell& cell = GetCell(from, to);
+    if (cell.weight == UNREACHABLE) {
+        return std::nullopt;
+    }
+    return cell.weight;
+}
+
+template <typename Weight>
+std::optional<Weight> MappedRouter<Weight>::VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const {
+    const Cell& cell = GetCell(from, to);
+    if (cell.weight == UNREACHABLE) {
+        return std::nullopt;
+    }
+    VisitEdgeChain(cell.prev_edge, NO_EDGE,
+                   [this, from](EdgeId edge_id) -> EdgeId {
+                       return GetCell(from, graph_.GetEdge(edge_id).from).prev_edge;
+                   },
+                   visitor);
+    return cell.weight;
+}
+
+template <typename Weight>
+const typename MappedRouter<Weight>::Cell& MappedRouter<Weight>::GetCell(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex is out of the route table");
+    }
+    return cells_[from * vertex_count + to];
+}
+
+}  // namespace graph
@@ -5,7 +5,9 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -14,20 +16,54 @@
 
 namespace graph {
 
+// Общий интерфейс алгоритмов поиска маршрута по графу
 template <typename Weight>
-class Router {
-private:
-    using Graph = DirectedWeightedGraph<Weight>;
-
+class RouterEngine {
 public:
-    explicit Router(const Graph& graph);
-
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Получатель рёбер пути в порядке следования
+    using EdgeVisitor = std::function<void(EdgeId)>;
+
+    virtual ~RouterEngine() = default;
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+    // Только вес кратчайшего пути, без восстановления рёбер
+    virtual std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const = 0;
+
+    // Рёбра кратчайшего пути передаются visitor по порядку, возвращается вес пути.
+    // По умолчанию путь собирается через BuildRoute; маршрутизаторы с цепочкой предшественников обходят её без вектора рёбер
+    virtual std::optional<Weight> VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const {
+        const auto route = BuildRoute(from, to);
+        if (!route) {
+            return std::nullopt;
+        }
+        for (const EdgeId edge_id : route->edges) {
+            visitor(edge_id);
+        }
+        return route->weight;
+    }
+};
+
+// Таблица кратчайших путей между всеми парами вершин (Флойд - Уоршелл).
+// Ячейка таблицы - вес и последнее ребро пути без optional, поэтому её размер определяется типом веса:
+// 16 байт для double и 8 байт для float и uint32_t
+template <typename Weight>
+class Router : public RouterEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterEngine<Weight>::RouteInfo;
+    using EdgeVisitor = typename RouterEngine<Weight>::EdgeVisitor;
+
+    explicit Router(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const override;
+    std::optional<Weight> VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const override;
 
     void Build() {
         InitializeRoutesInternalData(graph_);
@@ -38,24 +74,44 @@ public:
         }
     }
 private:
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
     struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
+        Weight weight = UNREACHABLE;
+        uint32_t prev_edge = NO_EDGE;
+
+        bool IsReachable() const {
+            return weight != UNREACHABLE;
+        }
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    // Строки таблицы лежат подряд: ячейка (from, to) имеет номер from * vertex_count + to
+    using RoutesInternalData = std::vector<RouteInternalData>;
+
+    RouteInternalData& GetRouteInternalData(VertexId from, VertexId to) {
+        return routes_internal_data_[from * graph_.GetVertexCount() + to];
+    }
+    const RouteInternalData& GetRouteInternalData(VertexId from, VertexId to) const {
+        return routes_internal_data_.at(from * graph_.GetVertexCount() + to);
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
+        if (graph.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for the routes table");
+        }
+
+        routes_internal_data_.assign(vertex_count * vertex_count, RouteInternalData{});
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            GetRouteInternalData(vertex, vertex) = RouteInternalData{ZERO_WEIGHT, NO_EDGE};
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                auto& route_internal_data = GetRouteInternalData(vertex, edge.to);
+                if (!route_internal_data.IsReachable() || route_internal_data.weight > edge.weight) {
+                    route_internal_data = RouteInternalData{edge.weight, static_cast<uint32_t>(edge_id)};
                 }
             }
         }
@@ -63,21 +119,24 @@ private:
 
     void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
                     const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
+        auto& route_relaxing = GetRouteInternalData(vertex_from, vertex_to);
         const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+        if (!route_relaxing.IsReachable() || candidate_weight < route_relaxing.weight) {
             route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+                              route_to.prev_edge != NO_EDGE ? route_to.prev_edge : route_from.prev_edge};
         }
     }
 
     void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
         for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+            const RouteInternalData route_from = GetRouteInternalData(vertex_from, vertex_through);
+            if (!route_from.IsReachable()) {
+                continue;
+            }
+            for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+                const RouteInternalData& route_to = GetRouteInternalData(vertex_through, vertex_to);
+                if (route_to.IsReachable()) {
+                    RelaxRoute(vertex_from, vertex_to, route_from, route_to);
                 }
             }
         }
@@ -91,8 +150,6 @@ private:
 template <typename Weight>
 Router<Weight>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
 {
     InitializeRoutesInternalData(graph);
 
@@ -105,21 +162,35 @@ Router<Weight>::Router(const Graph& graph)
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    std::vector<EdgeId> edges;
+    const auto weight = VisitRoute(from, to, [&edges](EdgeId edge_id) { edges.push_back(edge_id); });
+    if (!weight) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
-    {
-        edges.push_back(*edge_id);
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<Weight> Router<Weight>::VisitRoute(VertexId from, VertexId to, const EdgeVisitor& visitor) const {
+    const auto& route_internal_data = GetRouteInternalData(from, to);
+    if (!route_internal_data.IsReachable()) {
+        return std::nullopt;
     }
-    std::reverse(edges.begin(), edges.end());
+    VisitEdgeChain(route_internal_data.prev_edge, NO_EDGE,
+                   [this, from](EdgeId edge_id) -> EdgeId {
+                       return GetRouteInternalData(from, graph_.GetEdge(edge_id).from).prev_edge;
+                   },
+                   visitor);
+    return route_internal_data.weight;
+}
 
-    return RouteInfo{weight, std::move(edges)};
+template <typename Weight>
+std::optional<Weight> Router<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+    const auto& route_internal_data = GetRouteInternalData(from, to);
+    if (!route_internal_data.IsReachable()) {
+        return std::nullopt;
+    }
+    return route_internal_data.weight;
 }
 
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
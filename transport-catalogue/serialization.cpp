@@ -1,15 +1,10 @@
 #include "serialization.h"
+#include "flat_base.h"
+#include "columnar.h"
 
 namespace serialization {
 
-    template <typename It>
-    uint32_t CalculateId(It start, It end, std::string_view name) {
-
-        auto stop_it = std::find_if(start, end, [&name](const transport_catalogue::Stop stop) {return stop.name_stop == name; });
-        return std::distance(start, stop_it);
-    }
-
-    transport_catalogue_protobuf::TransportCatalogue TransportCatalogueSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue) {
+    transport_catalogue_protobuf::TransportCatalogue TransportCatalogueSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue, bool compact_coordinates) {
 
         transport_catalogue_protobuf::TransportCatalogue transport_catalogue_proto;
 
@@ -17,6 +12,9 @@ namespace serialization {
         const auto& buses = transport_catalogue.GetBuses();
         const auto& distances = transport_catalogue.GetDistance();
 
+        // Названия регионов хранятся один раз, у остановки - номер в таблице
+        std::unordered_map<std::string_view, uint32_t> region_to_id;
+
         int id = 0;
         for (const auto& stop : stops) {
 
@@ -24,8 +22,24 @@ namespace serialization {
 
             stop_proto.set_id(id);
             stop_proto.set_name(stop.name_stop);
-            stop_proto.set_latitude(stop.latitude);
-            stop_proto.set_longitude(stop.longitude);
+
+            if (!stop.region.empty()) {
+                auto [region_it, inserted] = region_to_id.insert({ stop.region, static_cast<uint32_t>(region_to_id.size() + 1) });
+                if (inserted) {
+                    transport_catalogue_proto.add_regions(stop.region);
+                }
+                stop_proto.set_region(region_it->second);
+            }
+
+            if (compact_coordinates) {
+                const auto coordinates = transport_catalogue::detail::geo::EncodeCoordinates({ stop.latitude, stop.longitude });
+                stop_proto.set_latitude_e7(coordinates.lat);
+                stop_proto.set_longitude_e7(coordinates.lng);
+            }
+            else {
+                stop_proto.set_latitude(stop.latitude);
+                stop_proto.set_longitude(stop.longitude);
+            }
 
             *transport_catalogue_proto.add_stops() = std::move(stop_proto);
 
@@ -38,11 +52,9 @@ namespace serialization {
 
             bus_proto.set_name(bus.name_bus);
 
-            for (auto stop : bus.stops_bus) {
-                uint32_t stop_id = CalculateId(stops.cbegin(),
-                    stops.cend(),
-                    stop->name_stop);
-                bus_proto.add_stops(stop_id);
+            // Номера остановок берутся из справочника, а не поиском по имени
+            for (const auto* stop : bus.stops_bus) {
+                bus_proto.add_stops(static_cast<uint32_t>(transport_catalogue.GetStopId(stop)));
             }
 
             bus_proto.set_is_roundtrip(bus.is_roundtrip);
@@ -55,19 +67,16 @@ namespace serialization {
 
             transport_catalogue_protobuf::Distance distance_proto;
 
-            distance_proto.set_start(CalculateId(stops.cbegin(),
-                stops.cend(),
-                pair_stops.first->name_stop));
-
-            distance_proto.set_end(CalculateId(stops.cbegin(),
-                stops.cend(),
-                pair_stops.second->name_stop));
+            distance_proto.set_start(static_cast<uint32_t>(transport_catalogue.GetStopId(pair_stops.first)));
+            distance_proto.set_end(static_cast<uint32_t>(transport_catalogue.GetStopId(pair_stops.second)));
 
             distance_proto.set_distance(pair_distance);
 
             *transport_catalogue_proto.add_distances() = std::move(distance_proto);
         }
 
+        transport_catalogue_proto.set_compact_coordinates(compact_coordinates);
+
         return transport_catalogue_proto;
     }
 
@@ -85,8 +94,20 @@ namespace serialization {
             transport_catalogue::Stop tc_stop;
 
             tc_stop.name_stop = stop.name();
-            tc_stop.latitude = stop.latitude();
-            tc_stop.longitude = stop.longitude();
+
+            if (stop.region() > 0) {
+                tc_stop.region = transport_catalogue_proto.regions(stop.region() - 1);
+            }
+
+            if (transport_catalogue_proto.compact_coordinates()) {
+                const auto coordinates = transport_catalogue::detail::geo::DecodeCoordinates({ stop.latitude_e7(), stop.longitude_e7() });
+                tc_stop.latitude = coordinates.lat;
+                tc_stop.longitude = coordinates.lng;
+            }
+            else {
+                tc_stop.latitude = stop.latitude();
+                tc_stop.longitude = stop.longitude();
+            }
 
             transport_catalogue.AddStop(std::move(tc_stop));
         }
@@ -115,8 +136,7 @@ namespace serialization {
             tc_bus.name_bus = bus_proto.name();
 
             for (auto stop_id : bus_proto.stops()) {
-                auto name = tc_stops[stop_id].name_stop;
-                tc_bus.stops_bus.push_back(transport_catalogue.FindStop(name));
+                tc_bus.stops_bus.push_back(transport_catalogue.FindStop(tc_stops[stop_id].name_stop));
             }
 
             tc_bus.is_roundtrip = bus_proto.is_roundtrip();
@@ -260,6 +280,23 @@ namespace serialization {
 
         routing_settings_proto.set_bus_wait_time(routing_settings.bus_wait_time);
         routing_settings_proto.set_bus_velocity(routing_settings.bus_velocity);
+        routing_settings_proto.set_router_mode(static_cast<uint32_t>(routing_settings.router_mode));
+        routing_settings_proto.set_router_memory_mb(routing_settings.router_memory_mb);
+        routing_settings_proto.set_route_weight(static_cast<uint32_t>(routing_settings.route_weight));
+        routing_settings_proto.set_hub_labels(routing_settings.hub_labels);
+        routing_settings_proto.set_route_cache_size(routing_settings.route_cache_size);
+        routing_settings_proto.set_walking_radius(routing_settings.walking_radius);
+        routing_settings_proto.set_walking_velocity(routing_settings.walking_velocity);
+        routing_settings_proto.set_route_table_file(routing_settings.route_table_file);
+        routing_settings_proto.set_route_table_huge_pages(routing_settings.route_table_huge_pages);
+
+        for (const auto& profile : routing_settings.profiles) {
+            auto& profile_proto = *routing_settings_proto.add_profiles();
+
+            profile_proto.set_name(profile.name);
+            profile_proto.set_bus_wait_time(profile.bus_wait_time);
+            profile_proto.set_bus_velocity(profile.bus_velocity);
+        }
 
         return routing_settings_proto;
     }
@@ -270,24 +307,281 @@ namespace serialization {
 
         routing_settings.bus_wait_time = routing_settings_proto.bus_wait_time();
         routing_settings.bus_velocity = routing_settings_proto.bus_velocity();
+        routing_settings.router_mode = static_cast<RouterMode>(routing_settings_proto.router_mode());
+        routing_settings.route_weight = static_cast<RouteWeight>(routing_settings_proto.route_weight());
+        routing_settings.hub_labels = routing_settings_proto.hub_labels();
+        routing_settings.route_cache_size = routing_settings_proto.route_cache_size();
+        routing_settings.walking_radius = routing_settings_proto.walking_radius();
+        if (routing_settings_proto.walking_velocity() > 0) {
+            routing_settings.walking_velocity = routing_settings_proto.walking_velocity();
+        }
+        routing_settings.route_table_file = routing_settings_proto.route_table_file();
+        routing_settings.route_table_huge_pages = routing_settings_proto.route_table_huge_pages();
+
+        for (const auto& profile_proto : routing_settings_proto.profiles()) {
+            routing_settings.profiles.push_back({ profile_proto.name(), profile_proto.bus_wait_time(), profile_proto.bus_velocity() });
+        }
+
+        if (routing_settings_proto.router_memory_mb() > 0) {
+            routing_settings.router_memory_mb = routing_settings_proto.router_memory_mb();
+        }
 
         return routing_settings;
     }
 
+    transport_catalogue_protobuf::SpatialIndex SpatialIndexSerialization(const transport_catalogue::detail::spatial::SpatialIndex& spatial_index) {
+
+        transport_catalogue_protobuf::SpatialIndex spatial_index_proto;
+
+        const auto& grid = spatial_index.GetGridSettings();
+        auto& grid_proto = *spatial_index_proto.mutable_grid();
+
+        grid_proto.set_min_lat(grid.min_lat);
+        grid_proto.set_min_lng(grid.min_lng);
+        grid_proto.set_cell_lat(grid.cell_lat);
+        grid_proto.set_cell_lng(grid.cell_lng);
+        grid_proto.set_rows(grid.rows);
+        grid_proto.set_cols(grid.cols);
+
+        for (auto cell_begin : spatial_index.GetCellBegin()) {
+            spatial_index_proto.add_cell_begin(cell_begin);
+        }
+
+        // Координаты не дублируются - при загрузке они берутся из остановок справочника
+        for (const auto& entry : spatial_index.GetEntries()) {
+            spatial_index_proto.add_stop_ids(entry.stop_id);
+        }
+
+        return spatial_index_proto;
+    }
+
+    transport_catalogue::detail::spatial::SpatialIndex SpatialIndexDeserialization(const transport_catalogue_protobuf::SpatialIndex& spatial_index_proto,
+        const transport_catalogue::TransportCatalogue& transport_catalogue) {
+
+        using namespace transport_catalogue::detail::spatial;
+
+        GridSettings grid;
+
+        grid.min_lat = spatial_index_proto.grid().min_lat();
+        grid.min_lng = spatial_index_proto.grid().min_lng();
+        grid.cell_lat = spatial_index_proto.grid().cell_lat();
+        grid.cell_lng = spatial_index_proto.grid().cell_lng();
+        grid.rows = spatial_index_proto.grid().rows();
+        grid.cols = spatial_index_proto.grid().cols();
+
+        std::vector<uint32_t> cell_begin(spatial_index_proto.cell_begin().begin(), spatial_index_proto.cell_begin().end());
+
+        std::vector<IndexEntry> entries;
+        entries.reserve(spatial_index_proto.stop_ids_size());
+
+        for (auto stop_id : spatial_index_proto.stop_ids()) {
+            const transport_catalogue::Stop* stop = transport_catalogue.GetStopById(stop_id);
+
+            if (!stop) {
+                throw std::runtime_error("spatial index refers to unknown stop");
+            }
+            entries.push_back({ stop_id, transport_catalogue::detail::geo::EncodeCoordinates({ stop->latitude, stop->longitude }) });
+        }
+
+        return SpatialIndex(std::move(grid), std::move(cell_begin), std::move(entries));
+    }
+
+    transport_catalogue_protobuf::StopComponents StopComponentsSerialization(const StopComponents& stop_components) {
+
+        transport_catalogue_protobuf::StopComponents stop_components_proto;
+
+        for (const auto& component : stop_components) {
+            stop_components_proto.add_strong(component.strong);
+            stop_components_proto.add_weak(component.weak);
+        }
+
+        return stop_components_proto;
+    }
+
+    StopComponents StopComponentsDeserialization(const transport_catalogue_protobuf::StopComponents& stop_components_proto) {
+
+        StopComponents stop_components;
+
+        if (stop_components_proto.strong_size() != stop_components_proto.weak_size()) {
+            throw std::runtime_error("stop components are inconsistent");
+        }
+
+        for (int i = 0; i < stop_components_proto.strong_size(); ++i) {
+            stop_components.push_back({ stop_components_proto.strong(i), stop_components_proto.weak(i) });
+        }
+
+        return stop_components;
+    }
+
+    transport_catalogue_protobuf::HubLabels HubLabelsSerialization(const StopHubLabels& stop_hub_labels) {
+
+        transport_catalogue_protobuf::HubLabels hub_labels_proto;
+        const auto& labels = stop_hub_labels.labels;
+
+        *hub_labels_proto.mutable_out_begin() = { labels.GetOutBegin().begin(), labels.GetOutBegin().end() };
+        *hub_labels_proto.mutable_in_begin() = { labels.GetInBegin().begin(), labels.GetInBegin().end() };
+
+        for (const auto& label : labels.GetOutLabels()) {
+            hub_labels_proto.add_out_hubs(label.hub);
+            hub_labels_proto.add_out_weights(label.weight);
+        }
+        for (const auto& label : labels.GetInLabels()) {
+            hub_labels_proto.add_in_hubs(label.hub);
+            hub_labels_proto.add_in_weights(label.weight);
+        }
+
+        hub_labels_proto.set_bus_wait_time(stop_hub_labels.bus_wait_time);
+        hub_labels_proto.set_bus_velocity(stop_hub_labels.bus_velocity);
+
+        return hub_labels_proto;
+    }
+
+    StopHubLabels HubLabelsDeserialization(const transport_catalogue_protobuf::HubLabels& hub_labels_proto) {
+
+        using Label = graph::HubLabels<double>::Label;
+
+        StopHubLabels stop_hub_labels;
+
+        if (hub_labels_proto.out_begin().empty()) {
+            return stop_hub_labels;
+        }
+
+        if (hub_labels_proto.out_hubs_size() != hub_labels_proto.out_weights_size() || hub_labels_proto.in_hubs_size() != hub_labels_proto.in_weights_size()) {
+            throw std::runtime_error("hub labels are inconsistent");
+        }
+
+        std::vector<Label> out_labels;
+        out_labels.reserve(hub_labels_proto.out_hubs_size());
+        for (int i = 0; i < hub_labels_proto.out_hubs_size(); ++i) {
+            out_labels.push_back({ hub_labels_proto.out_hubs(i), hub_labels_proto.out_weights(i) });
+        }
+
+        std::vector<Label> in_labels;
+        in_labels.reserve(hub_labels_proto.in_hubs_size());
+        for (int i = 0; i < hub_labels_proto.in_hubs_size(); ++i) {
+            in_labels.push_back({ hub_labels_proto.in_hubs(i), hub_labels_proto.in_weights(i) });
+        }
+
+        stop_hub_labels.labels = graph::HubLabels<double>({ hub_labels_proto.out_begin().begin(), hub_labels_proto.out_begin().end() }, std::move(out_labels),
+                                                          { hub_labels_proto.in_begin().begin(), hub_labels_proto.in_begin().end() }, std::move(in_labels));
+        stop_hub_labels.bus_wait_time = hub_labels_proto.bus_wait_time();
+        stop_hub_labels.bus_velocity = hub_labels_proto.bus_velocity();
+
+        return stop_hub_labels;
+    }
+
+    transport_catalogue_protobuf::StopWalks StopWalksSerialization(const StopWalks& stop_walks) {
+
+        transport_catalogue_protobuf::StopWalks stop_walks_proto;
+
+        for (const auto& walk : stop_walks) {
+            stop_walks_proto.add_first_id(walk.first_id);
+            stop_walks_proto.add_second_id(walk.second_id);
+            stop_walks_proto.add_distance(walk.distance);
+        }
+
+        return stop_walks_proto;
+    }
+
+    StopWalks StopWalksDeserialization(const transport_catalogue_protobuf::StopWalks& stop_walks_proto) {
+
+        StopWalks stop_walks;
+
+        if (stop_walks_proto.first_id_size() != stop_walks_proto.second_id_size() || stop_walks_proto.first_id_size() != stop_walks_proto.distance_size()) {
+            throw std::runtime_error("stop walks are corrupted");
+        }
+
+        for (int i = 0; i < stop_walks_proto.first_id_size(); ++i) {
+            stop_walks.push_back({ stop_walks_proto.first_id(i), stop_walks_proto.second_id(i), stop_walks_proto.distance(i) });
+        }
+
+        return stop_walks;
+    }
+
+    transport_catalogue_protobuf::ArcFlags ArcFlagsSerialization(const StopArcFlags& stop_arc_flags) {
+
+        transport_catalogue_protobuf::ArcFlags arc_flags_proto;
+
+        *arc_flags_proto.mutable_stop_cells() = { stop_arc_flags.stop_cells.begin(), stop_arc_flags.stop_cells.end() };
+        *arc_flags_proto.mutable_edge_flags() = { stop_arc_flags.edge_flags.begin(), stop_arc_flags.edge_flags.end() };
+        arc_flags_proto.set_bus_wait_time(stop_arc_flags.bus_wait_time);
+        arc_flags_proto.set_bus_velocity(stop_arc_flags.bus_velocity);
+
+        return arc_flags_proto;
+    }
+
+    StopArcFlags ArcFlagsDeserialization(const transport_catalogue_protobuf::ArcFlags& arc_flags_proto) {
+
+        StopArcFlags stop_arc_flags;
+
+        stop_arc_flags.stop_cells = { arc_flags_proto.stop_cells().begin(), arc_flags_proto.stop_cells().end() };
+        stop_arc_flags.edge_flags = { arc_flags_proto.edge_flags().begin(), arc_flags_proto.edge_flags().end() };
+        stop_arc_flags.bus_wait_time = arc_flags_proto.bus_wait_time();
+        stop_arc_flags.bus_velocity = arc_flags_proto.bus_velocity();
+
+        return stop_arc_flags;
+    }
+
+    transport_catalogue_protobuf::Catalogue CatalogueSectionsSerialization(const map_renderer::RenderSettings& render_settings,
+        const RoutingSettings& routing_settings,
+        const transport_catalogue::detail::spatial::SpatialIndex& spatial_index,
+        const StopComponents& stop_components,
+        const StopHubLabels& stop_hub_labels,
+        const StopArcFlags& stop_arc_flags,
+        const StopWalks& stop_walks) {
+
+        transport_catalogue_protobuf::Catalogue catalogue_proto;
+
+        *catalogue_proto.mutable_render_settings() = RenderSettingsSerialization(render_settings);
+        *catalogue_proto.mutable_routing_settings() = RoutingSettingsSerialization(routing_settings);
+        *catalogue_proto.mutable_spatial_index() = SpatialIndexSerialization(spatial_index);
+        *catalogue_proto.mutable_stop_components() = StopComponentsSerialization(stop_components);
+        *catalogue_proto.mutable_hub_labels() = HubLabelsSerialization(stop_hub_labels);
+        *catalogue_proto.mutable_arc_flags() = ArcFlagsSerialization(stop_arc_flags);
+        *catalogue_proto.mutable_stop_walks() = StopWalksSerialization(stop_walks);
+
+        return catalogue_proto;
+    }
+
+    Catalogue CatalogueSectionsDeserialization(const transport_catalogue_protobuf::Catalogue& catalogue_proto,
+        transport_catalogue::TransportCatalogue transport_catalogue) {
+
+        Catalogue catalogue;
+
+        catalogue.transport_catalogue_ = std::move(transport_catalogue);
+        catalogue.render_settings_ = RenderSettingsDeserialization(catalogue_proto.render_settings());
+        catalogue.routing_settings_ = RoutingSettingsDeserialization(catalogue_proto.routing_settings());
+        catalogue.spatial_index_ = SpatialIndexDeserialization(catalogue_proto.spatial_index(), catalogue.transport_catalogue_);
+        catalogue.stop_components_ = StopComponentsDeserialization(catalogue_proto.stop_components());
+        catalogue.stop_hub_labels_ = HubLabelsDeserialization(catalogue_proto.hub_labels());
+        catalogue.stop_arc_flags_ = ArcFlagsDeserialization(catalogue_proto.arc_flags());
+        catalogue.stop_walks_ = StopWalksDeserialization(catalogue_proto.stop_walks());
+
+        return catalogue;
+    }
+
     void CatalogueSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue,
         const map_renderer::RenderSettings& render_settings,
         const RoutingSettings& routing_settings,
+        const transport_catalogue::detail::spatial::SpatialIndex& spatial_index,
+        const StopComponents& stop_components,
+        const StopHubLabels& stop_hub_labels,
+        const StopArcFlags& stop_arc_flags,
+        const StopWalks& stop_walks,
+        const SerializationSettings& serialization_settings,
         std::ostream& out) {
 
-        transport_catalogue_protobuf::Catalogue catalogue_proto;
+        transport_catalogue_protobuf::Catalogue catalogue_proto = CatalogueSectionsSerialization(render_settings, routing_settings, spatial_index,
+            stop_components, stop_hub_labels, stop_arc_flags, stop_walks);
 
-        transport_catalogue_protobuf::TransportCatalogue transport_catalogue_proto = TransportCatalogueSerialization(transport_catalogue);
-        transport_catalogue_protobuf::RenderSettings render_settings_proto = RenderSettingsSerialization(render_settings);
-        transport_catalogue_protobuf::RoutingSettings routing_settings_proto = RoutingSettingsSerialization(routing_settings);
+        if (serialization_settings.format == BaseFormat::FLAT) {
+            FlatBaseSerialization(transport_catalogue, catalogue_proto, out);
+            return;
+        }
 
-        *catalogue_proto.mutable_transport_catalogue() = std::move(transport_catalogue_proto);
-        *catalogue_proto.mutable_render_settings() = std::move(render_settings_proto);
-        *catalogue_proto.mutable_routing_settings() = std::move(routing_settings_proto);
+        *catalogue_proto.mutable_transport_catalogue() = serialization_settings.columnar
+            ? ColumnarCatalogueSerialization(transport_catalogue)
+            : TransportCatalogueSerialization(transport_catalogue, serialization_settings.compact_coordinates);
 
         catalogue_proto.SerializePartialToOstream(&out);
     }
@@ -301,9 +595,11 @@ namespace serialization {
             throw std::runtime_error("cannot parse serialized file from istream");
         }
 
-        return { TransportCatalogueDeserialization(catalogue_proto.transport_catalogue()),
-                RenderSettingsDeserialization(catalogue_proto.render_settings()),
-                RoutingSettingsDeserialization(catalogue_proto.routing_settings()) };
+        const auto& transport_catalogue_proto = catalogue_proto.transport_catalogue();
+
+        return CatalogueSectionsDeserialization(catalogue_proto, transport_catalogue_proto.has_columnar()
+            ? ColumnarCatalogueDeserialization(transport_catalogue_proto)
+            : TransportCatalogueDeserialization(transport_catalogue_proto));
     }
 
 }
\ No newline at end of file
@@ -11,25 +11,39 @@
 #include "transport_router.h"
 #include "transport_router.pb.h"
 
+#include "spatial_index.h"
+#include "spatial_index.pb.h"
+
 #include <iostream>
 
 using namespace transport_catalogue::detail::router;
 namespace serialization {
 
+	// Формат файла базы
+	enum class BaseFormat {
+		PROTOBUF,		// одно сообщение Catalogue, разбирается целиком при загрузке
+		FLAT			// плоские массивы со смещениями, process_requests читает их на месте через mmap
+	};
+
 	struct SerializationSettings { 
 		std::string file_name; 
+		bool compact_coordinates = false;	// хранить координаты в фиксированной точке (sint32, 1e-7 градуса)
+		BaseFormat format = BaseFormat::PROTOBUF;
+		bool columnar = false;				// справочник protobuf-базы по сжатым столбцам, координаты - в фиксированной точке
 	};
 
 	struct Catalogue {
 		transport_catalogue::TransportCatalogue transport_catalogue_;
 		map_renderer::RenderSettings render_settings_;
 		RoutingSettings routing_settings_;
+		transport_catalogue::detail::spatial::SpatialIndex spatial_index_;
+		StopComponents stop_components_;
+		StopHubLabels stop_hub_labels_;
+		StopArcFlags stop_arc_flags_;
+		StopWalks stop_walks_;
 	};
 
-	template <typename It>
-	uint32_t CalculateId(It start, It end, std::string_view name);
-
-	transport_catalogue_protobuf::TransportCatalogue TransportCatalogueSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue);
+	transport_catalogue_protobuf::TransportCatalogue TransportCatalogueSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue, bool compact_coordinates);
 	transport_catalogue::TransportCatalogue TransportCatalogueDeserialization(const transport_catalogue_protobuf::TransportCatalogue& transport_catalogue_proto);
 
 	transport_catalogue_protobuf::Color ColorSerialize(const svg::Color& tc_color);
@@ -40,9 +54,42 @@ namespace serialization {
 	transport_catalogue_protobuf::RoutingSettings RoutingSettingsSerialization(const RoutingSettings& routing_settings);
 	RoutingSettings RoutingSettingsDeserialization(const transport_catalogue_protobuf::RoutingSettings& routing_settings_proto);
 
+	transport_catalogue_protobuf::SpatialIndex SpatialIndexSerialization(const transport_catalogue::detail::spatial::SpatialIndex& spatial_index);
+	transport_catalogue::detail::spatial::SpatialIndex SpatialIndexDeserialization(const transport_catalogue_protobuf::SpatialIndex& spatial_index_proto,
+		const transport_catalogue::TransportCatalogue& transport_catalogue);
+
+	transport_catalogue_protobuf::StopComponents StopComponentsSerialization(const StopComponents& stop_components);
+	StopComponents StopComponentsDeserialization(const transport_catalogue_protobuf::StopComponents& stop_components_proto);
+
+	transport_catalogue_protobuf::HubLabels HubLabelsSerialization(const StopHubLabels& stop_hub_labels);
+	StopHubLabels HubLabelsDeserialization(const transport_catalogue_protobuf::HubLabels& hub_labels_proto);
+
+	transport_catalogue_protobuf::StopWalks StopWalksSerialization(const StopWalks& stop_walks);
+	StopWalks StopWalksDeserialization(const transport_catalogue_protobuf::StopWalks& stop_walks_proto);
+
+	transport_catalogue_protobuf::ArcFlags ArcFlagsSerialization(const StopArcFlags& stop_arc_flags);
+	StopArcFlags ArcFlagsDeserialization(const transport_catalogue_protobuf::ArcFlags& arc_flags_proto);
+
+	// Всё, кроме справочника: настройки и предрасчёты маршрутизации. Общая часть обоих форматов базы
+	transport_catalogue_protobuf::Catalogue CatalogueSectionsSerialization(const map_renderer::RenderSettings& render_settings,
+		const RoutingSettings& routing_settings,
+		const transport_catalogue::detail::spatial::SpatialIndex& spatial_index,
+		const StopComponents& stop_components,
+		const StopHubLabels& stop_hub_labels,
+		const StopArcFlags& stop_arc_flags,
+		const StopWalks& stop_walks);
+	Catalogue CatalogueSectionsDeserialization(const transport_catalogue_protobuf::Catalogue& catalogue_proto,
+		transport_catalogue::TransportCatalogue transport_catalogue);
+
 	void CatalogueSerialization(const transport_catalogue::TransportCatalogue& transport_catalogue,
 		const map_renderer::RenderSettings& render_settings,
 		const RoutingSettings& routing_settings,
+		const transport_catalogue::detail::spatial::SpatialIndex& spatial_index,
+		const StopComponents& stop_components,
+		const StopHubLabels& stop_hub_labels,
+		const StopArcFlags& stop_arc_flags,
+		const StopWalks& stop_walks,
+		const SerializationSettings& serialization_settings,
 		std::ostream& out);
 	Catalogue CatalogueDeserialization(std::istream& in);
 
@@ -0,0 +1,276 @@
+#pragma once
+
+#include "dijkstra.h"
+#include "graph.h"
+#include "router.h"
+
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace graph {
+
+// Маршрутизатор по графу, разбитому на регионы.
+// Для каждого региона строится своя таблица кратчайших путей по внутренним рёбрам,
+// а переходы между регионами идут через граф границ: его вершины - концы межрегиональных рёбер,
+// рёбра - сами межрегиональные рёбра и кратчайшие пути между граничными вершинами внутри региона.
+// Рёбра автобусов соединяют все пары остановок маршрута, поэтому у межрегионального автобуса граничны
+// почти все остановки. Таблица по графу границ поэтому не строится: маршрут ищется по нему алгоритмом Дейкстры
+// сразу от всех выходов начального региона до входов конечного.
+// Память: сумма |V_r|^2 таблиц регионов, плюс межрегиональные рёбра, плюс |B_r|^2 путей по границе региона r.
+// Так как |B_r| <= |V_r|, всё это не больше суммы |V_r|^2 и растёт с размером регионов, а не всего графа.
+// Запрос - |B_from| + |B_to| чтений таблиц регионов и один поиск по графу границ.
+template <typename Weight>
+class ShardedRouter : public RouterEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    static constexpr VertexId NO_VERTEX = std::numeric_limits<VertexId>::max();
+
+public:
+    using RouteInfo = typename RouterEngine<Weight>::RouteInfo;
+
+    ShardedRouter(const Graph& graph, std::vector<size_t> vertex_region, size_t region_count);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const override;
+
+    size_t GetRegionCount() const {
+        return shards_.size();
+    }
+    size_t GetBoundaryVertexCount() const {
+        return overlay_to_vertex_.size();
+    }
+
+private:
+    struct Shard {
+        Graph graph;
+        std::unique_ptr<Router<Weight>> router;
+        std::vector<EdgeId> global_edges;       // номер ребра региона -> номер ребра исходного графа
+        std::vector<VertexId> boundary;         // граничные вершины в нумерации региона
+    };
+
+    // Ребро графа границ: межрегиональное ребро либо путь внутри региона
+    struct OverlayEdge {
+        std::optional<EdgeId> cross_edge;
+        size_t region = 0;
+        VertexId from = 0;
+        VertexId to = 0;
+    };
+
+    // План маршрута: путь внутри начального региона, путь по графу границ и путь внутри конечного региона
+    struct RoutePlan {
+        Weight weight;
+        VertexId exit = NO_VERTEX;
+        VertexId entry = NO_VERTEX;
+        std::vector<EdgeId> overlay_edges;
+    };
+
+    std::optional<RoutePlan> FindRoutePlan(VertexId from, VertexId to) const;
+    void AppendShardRoute(size_t region, VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+
+    const Graph& graph_;
+    std::vector<size_t> vertex_region_;
+    std::vector<VertexId> vertex_to_local_;
+    std::vector<std::vector<VertexId>> local_to_vertex_;
+    std::vector<Shard> shards_;
+
+    std::vector<VertexId> vertex_to_overlay_;
+    std::vector<VertexId> overlay_to_vertex_;
+    std::vector<OverlayEdge> overlay_edges_;
+    std::unique_ptr<Graph> overlay_graph_;
+};
+
+template <typename Weight>
+ShardedRouter<Weight>::ShardedRouter(const Graph& graph, std::vector<size_t> vertex_region, size_t region_count)
+    : graph_(graph)
+    , vertex_region_(std::move(vertex_region))
+    , vertex_to_local_(graph.GetVertexCount())
+    , local_to_vertex_(region_count)
+    , shards_(region_count)
+    , vertex_to_overlay_(graph.GetVertexCount(), NO_VERTEX)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        auto& local = local_to_vertex_.at(vertex_region_[vertex]);
+        vertex_to_local_[vertex] = local.size();
+        local.push_back(vertex);
+    }
+
+    for (size_t region = 0; region < region_count; ++region) {
+        shards_[region].graph = Graph(local_to_vertex_[region].size());
+    }
+
+    // Внутренние рёбра уходят в графы регионов, межрегиональные - в граф границ
+    std::vector<EdgeId> cross_edges;
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        const size_t region = vertex_region_[edge.from];
+
+        if (region == vertex_region_[edge.to]) {
+            auto& shard = shards_[region];
+            shard.graph.AddEdge({vertex_to_local_[edge.from], vertex_to_local_[edge.to], edge.weight});
+            shard.global_edges.push_back(edge_id);
+            continue;
+        }
+
+        cross_edges.push_back(edge_id);
+        for (VertexId vertex : {edge.from, edge.to}) {
+            if (vertex_to_overlay_[vertex] == NO_VERTEX) {
+                vertex_to_overlay_[vertex] = overlay_to_vertex_.size();
+                overlay_to_vertex_.push_back(vertex);
+                shards_[vertex_region_[vertex]].boundary.push_back(vertex_to_local_[vertex]);
+            }
+        }
+    }
+
+    for (auto& shard : shards_) {
+        shard.router = std::make_unique<Router<Weight>>(shard.graph);
+    }
+
+    overlay_graph_ = std::make_unique<Graph>(overlay_to_vertex_.size());
+    for (EdgeId edge_id : cross_edges) {
+        const auto& edge = graph.GetEdge(edge_id);
+        overlay_graph_->AddEdge({vertex_to_overlay_[edge.from], vertex_to_overlay_[edge.to], edge.weight});
+        overlay_edges_.push_back({edge_id, 0, 0, 0});
+    }
+    for (size_t region = 0; region < region_count; ++region) {
+        const auto& shard = shards_[region];
+        for (VertexId from : shard.boundary) {
+            for (VertexId to : shard.boundary) {
+                if (from == to) {
+                    continue;
+                }
+                if (const auto weight = shard.router->GetRouteWeight(from, to)) {
+                    overlay_graph_->AddEdge({vertex_to_overlay_[local_to_vertex_[region][from]],
+                                             vertex_to_overlay_[local_to_vertex_[region][to]], *weight});
+                    overlay_edges_.push_back({std::nullopt, region, from, to});
+                }
+            }
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ShardedRouter<Weight>::RoutePlan> ShardedRouter<Weight>::FindRoutePlan(VertexId from,
+                                                                                              VertexId to) const {
+    const size_t from_region = vertex_region_.at(from);
+    const size_t to_region = vertex_region_.at(to);
+    const VertexId local_from = vertex_to_local_[from];
+    const VertexId local_to = vertex_to_local_[to];
+    const Shard& from_shard = shards_[from_region];
+    const Shard& to_shard = shards_[to_region];
+
+    std::optional<RoutePlan> best;
+    if (from_region == to_region) {
+        if (const auto weight = from_shard.router->GetRouteWeight(local_from, local_to)) {
+            best = RoutePlan{*weight};
+        }
+    }
+
+    // Пути через другие регионы: выход из начального региона, граф границ, вход в конечный регион.
+    // Поиск идёт сразу от всех выходов с весами пути до них и не дальше уже найденного пути внутри региона
+    std::vector<std::pair<VertexId, Weight>> exits;
+    for (VertexId exit : from_shard.boundary) {
+        if (const auto weight = from_shard.router->GetRouteWeight(local_from, exit)) {
+            exits.push_back({vertex_to_overlay_[local_to_vertex_[from_region][exit]], *weight});
+        }
+    }
+    std::vector<std::pair<VertexId, Weight>> entries;
+    std::vector<VertexId> overlay_entries;
+    for (VertexId entry : to_shard.boundary) {
+        if (const auto weight = to_shard.router->GetRouteWeight(entry, local_to)) {
+            entries.push_back({entry, *weight});
+            overlay_entries.push_back(vertex_to_overlay_[local_to_vertex_[to_region][entry]]);
+        }
+    }
+    if (exits.empty() || entries.empty()) {
+        return best;
+    }
+
+    const auto tree = BuildShortestPathTreeToTargets(*overlay_graph_, exits, overlay_entries,
+                                                     best ? std::optional<Weight>(best->weight) : std::nullopt);
+    std::optional<size_t> best_entry;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (!tree.IsReachable(overlay_entries[i])) {
+            continue;
+        }
+        const Weight weight = tree.weights[overlay_entries[i]] + entries[i].second;
+        if (!best || weight < best->weight) {
+            best = RoutePlan{weight};
+            best_entry = i;
+        }
+    }
+    if (!best_entry) {
+        return best;
+    }
+
+    // Выход - начало пути по графу границ до выбранного входа
+    const VertexId overlay_entry = overlay_entries[*best_entry];
+    VertexId overlay_exit = overlay_entry;
+    tree.VisitPathEdges(*overlay_graph_, overlay_entry, [&](EdgeId edge_id) {
+        if (best->overlay_edges.empty()) {
+            overlay_exit = overlay_graph_->GetEdge(edge_id).from;
+        }
+        best->overlay_edges.push_back(edge_id);
+    });
+    best->exit = vertex_to_local_[overlay_to_vertex_[overlay_exit]];
+    best->entry = entries[*best_entry].first;
+
+    return best;
+}
+
+template <typename Weight>
+std::optional<Weight> ShardedRouter<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+    const auto plan = FindRoutePlan(from, to);
+    if (!plan) {
+        return std::nullopt;
+    }
+    return plan->weight;
+}
+
+template <typename Weight>
+std::optional<typename ShardedRouter<Weight>::RouteInfo> ShardedRouter<Weight>::BuildRoute(VertexId from,
+                                                                                           VertexId to) const {
+    const auto best = FindRoutePlan(from, to);
+    if (!best) {
+        return std::nullopt;
+    }
+
+    const size_t from_region = vertex_region_[from];
+    const size_t to_region = vertex_region_[to];
+    const VertexId local_from = vertex_to_local_[from];
+    const VertexId local_to = vertex_to_local_[to];
+
+    std::vector<EdgeId> edges;
+    if (best->exit == NO_VERTEX) {
+        AppendShardRoute(from_region, local_from, local_to, edges);
+        return RouteInfo{best->weight, std::move(edges)};
+    }
+
+    AppendShardRoute(from_region, local_from, best->exit, edges);
+    for (EdgeId overlay_edge_id : best->overlay_edges) {
+        const auto& overlay_edge = overlay_edges_[overlay_edge_id];
+        if (overlay_edge.cross_edge) {
+            edges.push_back(*overlay_edge.cross_edge);
+        } else {
+            AppendShardRoute(overlay_edge.region, overlay_edge.from, overlay_edge.to, edges);
+        }
+    }
+    AppendShardRoute(to_region, best->entry, local_to, edges);
+
+    return RouteInfo{best->weight, std::move(edges)};
+}
+
+template <typename Weight>
+void ShardedRouter<Weight>::AppendShardRoute(size_t region, VertexId from, VertexId to,
+                                             std::vector<EdgeId>& edges) const {
+    const Shard& shard = shards_[region];
+    const auto route = shard.router->BuildRoute(from, to);
+
+    for (EdgeId local_edge : route->edges) {
+        edges.push_back(shard.global_edges[local_edge]);
+    }
+}
+
+}  // namespace graph
@@ -0,0 +1,244 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace transport_catalogue {
+    namespace detail {
+        namespace spatial {
+
+            namespace {
+                const double METERS_PER_DEGREE = RADIUS_EARTH * NUMBER_PI / 180.0;
+
+                bool IsNearer(const NearestStop& lhs, const NearestStop& rhs) {
+                    return lhs.distance < rhs.distance
+                        || (lhs.distance == rhs.distance && lhs.stop_id < rhs.stop_id);
+                }
+            }
+
+            SpatialIndex::SpatialIndex(const std::deque<Stop>& stops) {
+                if (stops.empty()) {
+                    return;
+                }
+
+                double min_lat = stops.front().latitude;
+                double max_lat = stops.front().latitude;
+                double min_lng = stops.front().longitude;
+                double max_lng = stops.front().longitude;
+
+                for (const auto& stop : stops) {
+                    min_lat = std::min(min_lat, stop.latitude);
+                    max_lat = std::max(max_lat, stop.latitude);
+                    min_lng = std::min(min_lng, stop.longitude);
+                    max_lng = std::max(max_lng, stop.longitude);
+                }
+
+                // Размер сетки подбирается так, чтобы в ячейке было в среднем STOPS_PER_CELL остановок,
+                // а сами ячейки были примерно квадратными на местности
+                const double cells = std::ceil(stops.size() / STOPS_PER_CELL);
+                const double height_m = (max_lat - min_lat) * METERS_PER_DEGREE;
+                const double width_m = (max_lng - min_lng) * METERS_PER_DEGREE * std::cos((min_lat + max_lat) / 2.0 * NUMBER_PI / 180.0);
+
+                uint32_t cols = 1;
+                uint32_t rows = 1;
+                if (height_m > 0.0 && width_m > 0.0) {
+                    cols = static_cast<uint32_t>(std::max(1.0, std::round(std::sqrt(cells * width_m / height_m))));
+                    rows = static_cast<uint32_t>(std::max(1.0, std::ceil(cells / cols)));
+                }
+                else if (width_m > 0.0) {
+                    cols = static_cast<uint32_t>(cells);
+                }
+                else if (height_m > 0.0) {
+                    rows = static_cast<uint32_t>(cells);
+                }
+
+                grid_.min_lat = min_lat;
+                grid_.min_lng = min_lng;
+                grid_.rows = rows;
+                grid_.cols = cols;
+                // Ячейки чуть шире охвата, чтобы крайние остановки попадали внутрь сетки
+                grid_.cell_lat = max_lat > min_lat ? (max_lat - min_lat) / rows * (1.0 + 1e-9) : 1.0;
+                grid_.cell_lng = max_lng > min_lng ? (max_lng - min_lng) / cols * (1.0 + 1e-9) : 1.0;
+
+                // Раскладываем остановки по ячейкам подсчётом
+                std::vector<uint32_t> stop_cells(stops.size());
+                cell_begin_.assign(static_cast<size_t>(rows) * cols + 1, 0);
+
+                for (size_t id = 0; id < stops.size(); ++id) {
+                    const auto [row, col] = GetCell({ stops[id].latitude, stops[id].longitude });
+                    stop_cells[id] = static_cast<uint32_t>(row) * cols + col;
+                    ++cell_begin_[stop_cells[id] + 1];
+                }
+                for (size_t cell = 1; cell < cell_begin_.size(); ++cell) {
+                    cell_begin_[cell] += cell_begin_[cell - 1];
+                }
+
+                entries_.resize(stops.size());
+                std::vector<uint32_t> cell_fill(cell_begin_.begin(), std::prev(cell_begin_.end()));
+                for (size_t id = 0; id < stops.size(); ++id) {
+                    entries_[cell_fill[stop_cells[id]]++] = IndexEntry{ static_cast<uint32_t>(id),
+                                                                        geo::EncodeCoordinates({ stops[id].latitude, stops[id].longitude }) };
+                }
+            }
+
+            SpatialIndex::SpatialIndex(GridSettings grid, std::vector<uint32_t> cell_begin, std::vector<IndexEntry> entries)
+                : grid_(std::move(grid))
+                , cell_begin_(std::move(cell_begin))
+                , entries_(std::move(entries)) {}
+
+            std::vector<NearestStop> SpatialIndex::FindNearest(geo::Coordinates point, size_t count) const {
+                std::vector<NearestStop> nearest;
+
+                if (entries_.empty() || count == 0) {
+                    return nearest;
+                }
+
+                const auto [row, col] = GetCell(point);
+                const double min_extent = GetMinCellExtent();
+                const int max_ring = static_cast<int>(std::max(grid_.rows, grid_.cols));
+
+                // Обходим кольца ячеек вокруг точки, пока следующее кольцо может содержать более близкие остановки
+                for (int ring = 0; ring <= max_ring; ++ring) {
+                    for (int r = row - ring; r <= row + ring; ++r) {
+                        if (r < 0 || r >= static_cast<int>(grid_.rows)) {
+                            continue;
+                        }
+                        const bool edge_row = (r == row - ring || r == row + ring);
+                        const int step = edge_row ? 1 : 2 * ring;
+
+                        for (int c = col - ring; c <= col + ring; c += step) {
+                            if (c >= 0 && c < static_cast<int>(grid_.cols)) {
+                                ScanCell(r, c, point, count, nearest);
+                            }
+                        }
+                    }
+
+                    if (nearest.size() == count && nearest.back().distance <= ring * min_extent) {
+                        break;
+                    }
+                }
+                return nearest;
+            }
+
+            std::vector<uint32_t> SpatialIndex::FindInBox(geo::Coordinates min, geo::Coordinates max) const {
+                std::vector<uint32_t> result;
+
+                if (entries_.empty() || min.lat > max.lat || min.lng > max.lng) {
+                    return result;
+                }
+
+                const auto [min_row, min_col] = GetCell(min);
+                const auto [max_row, max_col] = GetCell(max);
+
+                // Округление монотонно, поэтому сравнение в фиксированной точке не теряет остановки внутри прямоугольника
+                const geo::CompactCoordinates compact_min = geo::EncodeCoordinates(min);
+                const geo::CompactCoordinates compact_max = geo::EncodeCoordinates(max);
+
+                for (int row = min_row; row <= max_row; ++row) {
+                    const size_t first_cell = static_cast<size_t>(row) * grid_.cols;
+
+                    for (uint32_t i = cell_begin_[first_cell + min_col]; i < cell_begin_[first_cell + max_col + 1]; ++i) {
+                        const auto& coordinates = entries_[i].coordinates;
+
+                        if (coordinates.lat >= compact_min.lat && coordinates.lat <= compact_max.lat
+                            && coordinates.lng >= compact_min.lng && coordinates.lng <= compact_max.lng) {
+                            result.push_back(entries_[i].stop_id);
+                        }
+                    }
+                }
+                std::sort(result.begin(), result.end());
+                return result;
+            }
+
+            std::vector<StopPair> SpatialIndex::FindPairsWithin(double radius) const {
+                std::vector<StopPair> pairs;
+
+                if (entries_.empty() || radius <= 0.0) {
+                    return pairs;
+                }
+
+                const double delta_lat = radius / METERS_PER_DEGREE;
+                const double max_latitude = std::min(std::max(std::abs(grid_.min_lat), std::abs(grid_.min_lat + grid_.rows * grid_.cell_lat)) + delta_lat, 90.0);
+                const geo::DistanceModel model = geo::SelectDistanceModel(radius, max_latitude, PAIR_DISTANCE_TOLERANCE);
+
+                // FindInBox возвращает номера остановок, координаты берутся из записей индекса
+                std::vector<uint32_t> stop_entries(entries_.size());
+                for (uint32_t i = 0; i < entries_.size(); ++i) {
+                    stop_entries[entries_[i].stop_id] = i;
+                }
+
+                for (const auto& entry : entries_) {
+                    const geo::Coordinates point = geo::DecodeCoordinates(entry.coordinates);
+                    // Ширина градуса долготы убывает к полюсам - берётся по ближнему к полюсу краю прямоугольника,
+                    // у самого полюса прямоугольник охватывает все долготы
+                    const double lng_scale = std::cos(std::min(std::abs(point.lat) + delta_lat, 90.0) * NUMBER_PI / 180.0);
+                    const double delta_lng = lng_scale > 1e-9 ? std::min(radius / (METERS_PER_DEGREE * lng_scale), 180.0) : 180.0;
+
+                    for (const uint32_t other_id : FindInBox({ point.lat - delta_lat, point.lng - delta_lng }, { point.lat + delta_lat, point.lng + delta_lng })) {
+                        if (other_id <= entry.stop_id) {
+                            continue;
+                        }
+
+                        const geo::Coordinates other = geo::DecodeCoordinates(entries_[stop_entries[other_id]].coordinates);
+                        const double distance = geo::ComputeDistance(point, other, model);
+
+                        if (distance <= radius) {
+                            // С теоремой косинусов, которой пары считались раньше, расходится не больше суммы оценок обеих моделей
+                            assert(std::abs(distance - geo::ComputeDistance(point, other)) <= geo::GetDistanceErrorBound(model, radius, max_latitude)
+                                + geo::GetDistanceErrorBound(geo::DistanceModel::SPHERICAL_COSINES, radius, max_latitude));
+                            pairs.push_back({ entry.stop_id, other_id, distance });
+                        }
+                    }
+                }
+
+                std::sort(pairs.begin(), pairs.end(), [](const StopPair& lhs, const StopPair& rhs) {
+                    return std::make_pair(lhs.first_id, lhs.second_id) < std::make_pair(rhs.first_id, rhs.second_id);
+                });
+                return pairs;
+            }
+
+            const GridSettings& SpatialIndex::GetGridSettings() const {
+                return grid_;
+            }
+            const std::vector<uint32_t>& SpatialIndex::GetCellBegin() const {
+                return cell_begin_;
+            }
+            const std::vector<IndexEntry>& SpatialIndex::GetEntries() const {
+                return entries_;
+            }
+
+            std::pair<int, int> SpatialIndex::GetCell(geo::Coordinates point) const {
+                const double row = std::floor((point.lat - grid_.min_lat) / grid_.cell_lat);
+                const double col = std::floor((point.lng - grid_.min_lng) / grid_.cell_lng);
+
+                return { static_cast<int>(std::clamp(row, 0.0, grid_.rows - 1.0)),
+                         static_cast<int>(std::clamp(col, 0.0, grid_.cols - 1.0)) };
+            }
+
+            void SpatialIndex::ScanCell(int row, int col, geo::Coordinates point, size_t count, std::vector<NearestStop>& nearest) const {
+                const size_t cell = static_cast<size_t>(row) * grid_.cols + col;
+
+                for (uint32_t i = cell_begin_[cell]; i < cell_begin_[cell + 1]; ++i) {
+                    NearestStop candidate{ entries_[i].stop_id, geo::ComputeDistance(point, geo::DecodeCoordinates(entries_[i].coordinates)) };
+
+                    if (nearest.size() == count && !IsNearer(candidate, nearest.back())) {
+                        continue;
+                    }
+                    nearest.insert(std::upper_bound(nearest.begin(), nearest.end(), candidate, IsNearer), candidate);
+                    if (nearest.size() > count) {
+                        nearest.pop_back();
+                    }
+                }
+            }
+
+            // Нижняя оценка расстояния в метрах, соответствующего одной ячейке по любой из осей
+            double SpatialIndex::GetMinCellExtent() const {
+                const double max_lat = std::max(std::abs(grid_.min_lat), std::abs(grid_.min_lat + grid_.rows * grid_.cell_lat));
+                const double lng_scale = std::cos(std::min(max_lat, 90.0) * NUMBER_PI / 180.0);
+
+                return METERS_PER_DEGREE * std::min(grid_.cell_lat, grid_.cell_lng * std::max(lng_scale, 0.0));
+            }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "geo.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+    namespace detail {
+        namespace spatial {
+
+            const double STOPS_PER_CELL = 2.0;
+            const double PAIR_DISTANCE_TOLERANCE = 0.01;   // допустимая ошибка расстояния в FindPairsWithin, в метрах
+
+            // Запись индекса - номер остановки в справочнике и её координаты в фиксированной точке
+            struct IndexEntry {
+                uint32_t stop_id;
+                geo::CompactCoordinates coordinates;
+            };
+
+            // Результат поиска ближайших остановок
+            struct NearestStop {
+                uint32_t stop_id;
+                double distance;
+            };
+
+            // Пара остановок не дальше заданного расстояния друг от друга, first_id < second_id
+            struct StopPair {
+                uint32_t first_id;
+                uint32_t second_id;
+                double distance;
+            };
+
+            // Параметры равномерной сетки, покрывающей все остановки
+            struct GridSettings {
+                double min_lat = 0.0;
+                double min_lng = 0.0;
+                double cell_lat = 1.0;     // высота ячейки в градусах
+                double cell_lng = 1.0;     // ширина ячейки в градусах
+                uint32_t rows = 0;
+                uint32_t cols = 0;
+            };
+
+            // Пространственный индекс остановок - равномерная сетка.
+            // Остановки хранятся сгруппированными по ячейкам (CSR): cell_begin_[c]..cell_begin_[c + 1]
+            class SpatialIndex {
+            public:
+                SpatialIndex() = default;
+                explicit SpatialIndex(const std::deque<Stop>& stops);
+                SpatialIndex(GridSettings grid, std::vector<uint32_t> cell_begin, std::vector<IndexEntry> entries);
+
+                // count ближайших к точке остановок, отсортированных по расстоянию.
+                // Расстояния считаются по сжатым координатам и отличаются от точных не больше чем на пару сантиметров
+                std::vector<NearestStop> FindNearest(geo::Coordinates point, size_t count) const;
+                // Остановки внутри прямоугольника [min, max]
+                std::vector<uint32_t> FindInBox(geo::Coordinates min, geo::Coordinates max) const;
+                // Все пары остановок на расстоянии не больше radius метров: для каждой остановки просматриваются
+                // только ячейки вокруг неё, а не все остановки. Пары упорядочены по номерам остановок.
+                // Расстояния считаются самой дешёвой моделью с ошибкой не больше PAIR_DISTANCE_TOLERANCE
+                std::vector<StopPair> FindPairsWithin(double radius) const;
+
+                const GridSettings& GetGridSettings() const;
+                const std::vector<uint32_t>& GetCellBegin() const;
+                const std::vector<IndexEntry>& GetEntries() const;
+
+            private:
+                std::pair<int, int> GetCell(geo::Coordinates point) const;
+                void ScanCell(int row, int col, geo::Coordinates point, size_t count, std::vector<NearestStop>& nearest) const;
+                double GetMinCellExtent() const;
+
+                GridSettings grid_;
+                std::vector<uint32_t> cell_begin_;
+                std::vector<IndexEntry> entries_;
+            };
+        }
+    }
+}
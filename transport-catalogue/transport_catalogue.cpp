@@ -7,6 +7,9 @@ namespace transport_catalogue {
 		stops_.push_back(std::move(stop));
 		Stop* buffer = &stops_.back();
 		stopname_to_stop_.insert({ buffer->name_stop, buffer });
+		stop_to_id_.insert({ buffer, stops_.size() - 1 });
+
+		buffer->trig_coordinates = detail::geo::ComputeTrigCoordinates({ buffer->latitude, buffer->longitude });
 	}
 
 	// Метод добавления маршрута в базу
@@ -20,6 +23,7 @@ namespace transport_catalogue {
 		}
 
 		buffer->route_length = GetDistanceBus(buffer);
+		buffer->geo_length = GetComputeDistance(buffer);
 	}
 
 	// Метод добавления дистанции в базу
@@ -50,15 +54,52 @@ namespace transport_catalogue {
 		}
 	}
 
+	// Метод получения остановки по порядковому номеру
+	const Stop* TransportCatalogue::GetStopById(size_t id) const {
+		if (id < stops_.size()) {
+			return &stops_[id];
+		}
+		else {
+			return nullptr;
+		}
+	}
+
+	// Метод получения маршрута по порядковому номеру, номер назначается при добавлении
+	const Bus* TransportCatalogue::GetBusById(size_t id) const {
+		if (id < buses_.size()) {
+			return &buses_[id];
+		}
+		else {
+			return nullptr;
+		}
+	}
+
+	// Метод получения порядкового номера остановки, номер назначается при добавлении и совпадает с индексом в GetStopById
+	size_t TransportCatalogue::GetStopId(const Stop* stop) const {
+		return stop_to_id_.at(stop);
+	}
+
 	// Метод получает информацию о дистанции
-	double TransportCatalogue::GetComputeDistance(const Bus* bus) {
-		return transform_reduce(next(bus->stops_bus.begin()),
-			bus->stops_bus.end(), bus->stops_bus.begin(), 0.0, std::plus<>{},
-			[](const Stop* lhs, const Stop* rhs) {
-				return detail::geo::ComputeDistance({ (*lhs).latitude,
-										(*lhs).longitude }, { (*rhs).latitude,
-															  (*rhs).longitude });
-			});
+	double TransportCatalogue::GetComputeDistance(const Bus* bus, detail::geo::DistanceModel model) {
+		// Дешёвые модели считаются пакетно: остановки собираются в структуру массивов, и ядро идёт по ней
+		// векторными загрузками. Остановки разбросаны по deque, поэтому без этого сбора векторизовать нечего
+		if (model == detail::geo::DistanceModel::EQUIRECTANGULAR || model == detail::geo::DistanceModel::POLYNOMIAL) {
+			detail::geo::TrigSequence sequence;
+			sequence.Reserve(bus->stops_bus.size());
+
+			for (const Stop* stop : bus->stops_bus) {
+				sequence.PushBack(stop->trig_coordinates);
+			}
+			return detail::geo::ComputeSequenceDistance(sequence, model);
+		}
+
+		double distance = 0.0;
+
+		// sin/cos широт берутся из остановок, на пару соседних остановок - одна пара вызовов cos и acos
+		for (size_t i = 1; i < bus->stops_bus.size(); ++i) {
+			distance += detail::geo::ComputeDistance(bus->stops_bus[i - 1]->trig_coordinates, bus->stops_bus[i]->trig_coordinates, model);
+		}
+		return distance;
 	}
 
 	std::unordered_set<const Stop*>  TransportCatalogue::GetUniqStops(Bus* bus) {
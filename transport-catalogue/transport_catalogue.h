@@ -35,6 +35,9 @@ namespace transport_catalogue {
 		double longitude;
 
 		std::vector<Bus*> buses_vector;
+		std::string region;				// Регион остановки для разбиения маршрутизатора, пустой - регион по умолчанию
+		detail::geo::TrigCoordinates trig_coordinates;	// Координаты с вычисленными sin/cos широты, заполняются при добавлении
+
 	};
 
 	// Bus — название структуры для маршрута
@@ -44,6 +47,7 @@ namespace transport_catalogue {
 
 		bool is_roundtrip;
 		size_t route_length;
+		double geo_length;			// Географическая длина маршрута, вычисляется при добавлении
 	};
 
 	// Distance - название структуры для дистанции
@@ -74,7 +78,11 @@ namespace transport_catalogue {
 		void AddDistance(const std::vector<Distance>& distance);												// Метод добавления дистанции в базу
 		Stop* FindStop(std::string_view find_stop);																// Метод поиска остановки
 		Bus* FindBus(std::string_view find_bus);																// Метод поиска маршрута
-		double GetComputeDistance(const Bus* bus);																// Метод получает информацию о дистанции
+		const Stop* GetStopById(size_t id) const;																// Метод получения остановки по порядковому номеру
+		size_t GetStopId(const Stop* stop) const;																// Метод получения порядкового номера остановки
+		const Bus* GetBusById(size_t id) const;																	// Метод получения маршрута по порядковому номеру
+		double GetComputeDistance(const Bus* bus,
+			detail::geo::DistanceModel model = detail::geo::DistanceModel::SPHERICAL_COSINES);					// Метод получает информацию о дистанции
 		std::unordered_set<const Stop*> GetUniqStops(Bus* bus);
 		std::unordered_set<const Bus*> GetUniqBuses(Stop* stop);
 		size_t GetDistanceStop(const Stop* a, const Stop* b) const;
@@ -90,6 +98,7 @@ namespace transport_catalogue {
 		std::deque<Stop> stops_;																				// Контейнер для хранения остановок
 		std::deque<Bus> buses_;																					// Контейнер для хранения маршрута
 		std::unordered_map<std::string_view, Stop*> stopname_to_stop_;											// Хеш таблица которая имя остановок переводит в указатель
+		std::unordered_map<const Stop*, size_t> stop_to_id_;													// Хеш таблица которая указатель остановки переводит в порядковый номер
 		std::unordered_map<std::string_view, Bus*> busname_to_bus_;												// Хеш таблица которая имя маршрута переводит в указатель
 		std::unordered_map<std::pair<const Stop*, const Stop*>, int, DistanceHasher> distance_to_stop_;			// Контейнер для расстояние между остановками
 	};
@@ -1,9 +1,40 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+
 namespace transport_catalogue {
     namespace detail {
         namespace router {
 
+            namespace {
+                // Номер клетки (x, y) сетки 2^order x 2^order вдоль кривой Гильберта
+                uint64_t ComputeHilbertIndex(uint32_t x, uint32_t y, int order) {
+                    uint64_t index = 0;
+
+                    for (uint32_t s = 1u << (order - 1); s > 0; s >>= 1) {
+                        const uint32_t rx = (x & s) ? 1 : 0;
+                        const uint32_t ry = (y & s) ? 1 : 0;
+                        index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+                        // Поворот четверти, чтобы кривая оставалась непрерывной
+                        if (ry == 0) {
+                            if (rx == 1) {
+                                x = s - 1 - (x & (s - 1));
+                                y = s - 1 - (y & (s - 1));
+                            }
+                            std::swap(x, y);
+                        }
+                        x &= s - 1;
+                        y &= s - 1;
+                    }
+                    return index;
+                }
+            }
+
             void TransportRouter::SetRoutingSettings(RoutingSettings routing_settings) {
                 routing_settings_ = std::move(routing_settings);
             }
@@ -11,19 +42,191 @@ namespace transport_catalogue {
                 return routing_settings_;
             }
 
+            void TransportRouter::SetStopComponents(StopComponents stop_components) {
+                stop_components_ = std::move(stop_components);
+            }
+
+            StopComponents TransportRouter::ComputeStopComponents(TransportCatalogue& transport_catalogue) const {
+                const std::vector<size_t> strong = ComputeStrongComponents(*graph_);
+                const std::vector<size_t> weak = ComputeWeakComponents(*graph_);
+                StopComponents result;
+
+                for (size_t id = 0; const Stop* stop = transport_catalogue.GetStopById(id); ++id) {
+                    const VertexId vertex = stop_to_router_.at(transport_catalogue.FindStop(stop->name_stop)).bus_wait_start;
+                    result.push_back({ static_cast<uint32_t>(strong[vertex]), static_cast<uint32_t>(weak[vertex]) });
+                }
+                return result;
+            }
+
+            void TransportRouter::SetStopWalks(StopWalks stop_walks) {
+                stop_walks_ = std::move(stop_walks);
+            }
+
+            void TransportRouter::SetStopHubLabels(StopHubLabels stop_hub_labels) {
+                stop_hub_labels_ = std::move(stop_hub_labels);
+            }
+
+            StopHubLabels TransportRouter::ComputeStopHubLabels(TransportCatalogue& transport_catalogue) const {
+                std::vector<VertexId> terminals;
+
+                for (size_t id = 0; const Stop* stop = transport_catalogue.GetStopById(id); ++id) {
+                    terminals.push_back(stop_to_router_.at(transport_catalogue.FindStop(stop->name_stop)).bus_wait_start);
+                }
+                return { HubLabels<double>(*graph_, terminals), routing_settings_.bus_wait_time, routing_settings_.bus_velocity };
+            }
+
+            void TransportRouter::SetStopArcFlags(StopArcFlags stop_arc_flags) {
+                stop_arc_flags_ = std::move(stop_arc_flags);
+            }
+
+            // Ячейки - равномерная сетка ARC_FLAG_GRID x ARC_FLAG_GRID по охвату остановок,
+            // обе вершины остановки лежат в её ячейке
+            StopArcFlags TransportRouter::ComputeStopArcFlags(TransportCatalogue& transport_catalogue) const {
+                StopArcFlags result{ {}, {}, routing_settings_.bus_wait_time, routing_settings_.bus_velocity };
+                const auto& stops = transport_catalogue.GetStops();
+
+                if (stops.empty()) {
+                    return result;
+                }
+
+                auto [min_lat, max_lat] = std::minmax_element(stops.begin(), stops.end(), [](const Stop& lhs, const Stop& rhs) {
+                    return lhs.latitude < rhs.latitude;
+                });
+                auto [min_lng, max_lng] = std::minmax_element(stops.begin(), stops.end(), [](const Stop& lhs, const Stop& rhs) {
+                    return lhs.longitude < rhs.longitude;
+                });
+
+                const double cell_lat = std::max(max_lat->latitude - min_lat->latitude, 1e-9) / ARC_FLAG_GRID;
+                const double cell_lng = std::max(max_lng->longitude - min_lng->longitude, 1e-9) / ARC_FLAG_GRID;
+                std::vector<uint32_t> vertex_cells(graph_->GetVertexCount(), 0);
+
+                for (const auto& stop : stops) {
+                    const auto row = std::min(static_cast<uint32_t>((stop.latitude - min_lat->latitude) / cell_lat), ARC_FLAG_GRID - 1);
+                    const auto col = std::min(static_cast<uint32_t>((stop.longitude - min_lng->longitude) / cell_lng), ARC_FLAG_GRID - 1);
+                    const RouterByStop& vertexes = stop_to_router_.at(transport_catalogue.FindStop(stop.name_stop));
+
+                    result.stop_cells.push_back(row * ARC_FLAG_GRID + col);
+                    vertex_cells[vertexes.bus_wait_start] = result.stop_cells.back();
+                    vertex_cells[vertexes.bus_wait_end] = result.stop_cells.back();
+                }
+
+                result.edge_flags = ComputeArcFlags(*graph_, vertex_cells);
+                return result;
+            }
+
+            // Таблица строится по основному графу с весами из настроек make_base
+            void TransportRouter::WriteRouteTable() const {
+                graph::WriteRouteTable(*graph_, routing_settings_.route_table_file);
+            }
+
             void TransportRouter::BuildRouter(TransportCatalogue& transport_catalogue) {
                 SetGraph(transport_catalogue);
-                router_ = std::make_unique<Router<double>>(*graph_);
-                router_->Build();
+                SetVertexComponents(transport_catalogue);
+                SetVertexTerminals(transport_catalogue);
+                SetVertexCells(transport_catalogue);
+                BuildEngine();
+            }
+
+            // Новые настройки применяются к готовому графу: пересчитываются веса рёбер и таблицы маршрутов,
+            // а остановки, рёбра и компоненты связности остаются прежними
+            void TransportRouter::Customize(RoutingSettings routing_settings) {
+                routing_settings_ = std::move(routing_settings);
+                ApplyMetric();
+                BuildEngine();
+            }
+
+            // Скорость пешехода одна для всех профилей, они меняют только ожидание и скорость автобуса
+            double TransportRouter::ComputeEdgeWeight(EdgeId id, const std::variant<StopEdge, BusEdge, WalkEdge>& edge, double bus_wait_time, double bus_velocity) const {
+                if (std::holds_alternative<StopEdge>(edge)) {
+                    return bus_wait_time;
+                }
+                else if (std::holds_alternative<BusEdge>(edge)) {
+                    return ComputeBusTime(edge_distances_[id], bus_velocity);
+                }
+                else {
+                    return ComputeBusTime(edge_distances_[id], routing_settings_.walking_velocity);
+                }
+            }
+
+            void TransportRouter::ApplyMetric() {
+                for (auto& [id, edge] : edge_id_to_edge_) {
+                    const double weight = ComputeEdgeWeight(id, edge, routing_settings_.bus_wait_time, routing_settings_.bus_velocity);
+
+                    std::visit([weight](auto& route_edge) { route_edge.time = weight; }, edge);
+                    graph_->SetEdgeWeight(id, weight);
+                }
+            }
+
+            void TransportRouter::BuildEngine() {
+                // Метки и флаги годятся только для тех весов, по которым построены
+                use_hub_labels_ = !vertex_to_terminal_.empty()
+                    && stop_hub_labels_.bus_wait_time == routing_settings_.bus_wait_time
+                    && stop_hub_labels_.bus_velocity == routing_settings_.bus_velocity;
+                use_arc_flags_ = !vertex_cells_.empty()
+                    && stop_arc_flags_.bus_wait_time == routing_settings_.bus_wait_time
+                    && stop_arc_flags_.bus_velocity == routing_settings_.bus_velocity;
+
+                router_ = MakeRouter(*graph_);
+
+                std::lock_guard guard(profile_mutex_);
+                profile_routers_.clear();
+            }
+
+            // Кеш маршрутов, если он включён, стоит перед маршрутизатором: у каждого профиля свой.
+            // Децисекунды меняют только очередь поиска Дейкстры, веса и таблицы остаются точными: таблица всех пар
+            // строится без очереди и в этом режиме та же, что для DOUBLE.
+            // Таблица из файла берётся, только если она построена по этому же графу, иначе таблица строится в памяти
+            std::unique_ptr<RouterEngine<double>> TransportRouter::MakeRouter(const DirectedWeightedGraph<double>& graph) const {
+                size_t region_count = 0;
+                std::vector<size_t> vertex_region = GetVertexRegions(region_count);
+                std::unique_ptr<RouterEngine<double>> router;
+
+                const bool deciseconds = routing_settings_.route_weight == RouteWeight::DECISECONDS;
+                // Все режимы, кроме ALL_PAIRS и флагов дуг, ищут через LazyRouter - его кеш деревьев не потокобезопасен
+                bool lazy_engine = routing_settings_.router_mode != RouterMode::ALL_PAIRS;
+
+                if (routing_settings_.router_mode == RouterMode::ARC_FLAGS && routing_settings_.route_weight != RouteWeight::FLOAT
+                    && use_arc_flags_ && &graph == graph_.get()) {
+                    lazy_engine = false;
+                    if (deciseconds) {
+                        router = std::make_unique<ArcFlagRouter<double, QuantizedHeap<double>>>(graph, vertex_cells_, stop_arc_flags_.edge_flags,
+                            QuantizedHeap<double>(DECISECONDS_PER_MINUTE));
+                    }
+                    else {
+                        router = std::make_unique<ArcFlagRouter<double>>(graph, vertex_cells_, stop_arc_flags_.edge_flags);
+                    }
+                }
+                else if (routing_settings_.router_mode == RouterMode::ALL_PAIRS && routing_settings_.route_weight != RouteWeight::FLOAT
+                    && !routing_settings_.route_table_file.empty() && &graph == graph_.get() && IsRouteTableFor(routing_settings_.route_table_file, graph)) {
+                    router = std::make_unique<MappedRouter<double>>(graph, routing_settings_.route_table_file, routing_settings_.route_table_huge_pages);
+                }
+                else if (routing_settings_.router_mode != RouterMode::ALL_PAIRS && deciseconds) {
+                    router = std::make_unique<LazyRouter<double, QuantizedHeap<double>>>(graph, routing_settings_.router_memory_mb * 1024 * 1024,
+                        QuantizedHeap<double>(DECISECONDS_PER_MINUTE));
+                }
+                else if (routing_settings_.route_weight == RouteWeight::FLOAT) {
+                    router = std::make_unique<QuantizedRouter<double, float>>(graph, 1.0,
+                        [&](const DirectedWeightedGraph<float>& graph) {
+                            return MakeEngine(graph, std::move(vertex_region), region_count);
+                        });
+                }
+                else {
+                    router = MakeEngine(graph, std::move(vertex_region), region_count);
+                }
+
+                if (routing_settings_.route_cache_size > 0) {
+                    router = std::make_unique<CachedRouter<double>>(std::move(router), graph.GetVertexCount(), routing_settings_.route_cache_size, lazy_engine);
+                }
+                return router;
             }
 
             const DirectedWeightedGraph<double>& TransportRouter::GetGraph() const {
                 return *graph_;
             }
-            const Router<double>& TransportRouter::GetRouter() const {
+            const RouterEngine<double>& TransportRouter::GetRouter() const {
                 return *router_;
             }
-            const std::variant<StopEdge, BusEdge>& TransportRouter::GetEdge(EdgeId id) const {
+            const std::variant<StopEdge, BusEdge, WalkEdge>& TransportRouter::GetEdge(EdgeId id) const {
                 return edge_id_to_edge_.at(id);
             }
 
@@ -35,28 +238,250 @@ namespace transport_catalogue {
                     return stop_to_router_.at(stop);
                 }
             }
-            std::optional<RouteInfo>TransportRouter::GetRouteInfo(VertexId start, VertexId end) const {
-                const auto& route_info = router_->BuildRoute(start, end);
-                
-                if (!route_info) {
+            // Проверка за O(1) до поиска: вершины в разных компонентах слабой связности не соединены никаким путём
+            bool TransportRouter::IsUnreachable(VertexId start, VertexId end) const {
+                if (start == end || vertex_components_.empty()) {
+                    return false;
+                }
+
+                const VertexComponent& from = vertex_components_[start];
+                const VertexComponent& to = vertex_components_[end];
+
+                if (from.weak == VertexComponent::NO_COMPONENT || to.weak == VertexComponent::NO_COMPONENT || from.strong == to.strong) {
+                    return false;
+                }
+                return from.weak != to.weak;
+            }
+
+            // Граф профиля - копия общего графа с весами профиля. Неизвестный профиль - nullptr.
+            // Вызывается под profile_mutex_
+            TransportRouter::ProfileRouter* TransportRouter::FindProfileRouter(std::string_view profile) const {
+                const std::string name(profile);
+                if (const auto it = profile_routers_.find(name); it != profile_routers_.end()) {
+                    return &it->second;
+                }
+
+                const auto profile_it = std::find_if(routing_settings_.profiles.begin(), routing_settings_.profiles.end(),
+                    [profile](const RoutingProfile& routing_profile) { return routing_profile.name == profile; });
+                if (profile_it == routing_settings_.profiles.end()) {
+                    return nullptr;
+                }
+
+                ProfileRouter profile_router;
+                profile_router.graph = std::make_unique<DirectedWeightedGraph<double>>(*graph_);
+
+                for (const auto& [id, edge] : edge_id_to_edge_) {
+                    profile_router.graph->SetEdgeWeight(id, ComputeEdgeWeight(id, edge, profile_it->bus_wait_time, profile_it->bus_velocity));
+                }
+
+                return &profile_routers_.emplace(name, std::move(profile_router)).first->second;
+            }
+
+            // Пустое имя - граф с весами из основных настроек
+            const DirectedWeightedGraph<double>* TransportRouter::GetProfileGraph(std::string_view profile) const {
+                if (profile.empty()) {
+                    return graph_.get();
+                }
+
+                std::lock_guard guard(profile_mutex_);
+                const ProfileRouter* profile_router = FindProfileRouter(profile);
+                return profile_router ? profile_router->graph.get() : nullptr;
+            }
+
+            std::pair<const DirectedWeightedGraph<double>*, const RouterEngine<double>*> TransportRouter::GetProfileRouter(std::string_view profile) const {
+                if (profile.empty()) {
+                    return { graph_.get(), router_.get() };
+                }
+
+                std::lock_guard guard(profile_mutex_);
+                ProfileRouter* profile_router = FindProfileRouter(profile);
+                if (!profile_router) {
+                    return { nullptr, nullptr };
+                }
+
+                if (!profile_router->router) {
+                    profile_router->router = MakeRouter(*profile_router->graph);
+                }
+                return { profile_router->graph.get(), profile_router->router.get() };
+            }
+
+            std::optional<RouteInfo>TransportRouter::GetRouteInfo(VertexId start, VertexId end, std::string_view profile) const {
+                RouteInfo route_info;
+                const auto total_time = VisitRoute(start, end, profile, [&route_info](const std::variant<StopEdge, BusEdge, WalkEdge>& item) {
+                    route_info.edges.push_back(item);
+                });
+
+                if (!total_time) {
+                    return std::nullopt;
+                }
+                route_info.total_time = *total_time;
+                return route_info;
+            }
+            // Участки передаются visitor по мере обхода цепочки предшественников, без векторов рёбер и участков.
+            // Время участка берётся из графа профиля, по которому найден маршрут
+            std::optional<double> TransportRouter::VisitRoute(VertexId start, VertexId end, std::string_view profile, const RouteItemVisitor& visitor) const {
+                if (IsUnreachable(start, end)) {
+                    return std::nullopt;
+                }
+
+                const auto [graph, router] = GetProfileRouter(profile);
+                if (!router) {
                     return std::nullopt;
                 }
-                else {
-                    RouteInfo result;
-                    result.total_time = route_info->weight;
 
-                    for (const auto edge : route_info->edges) {
-                        result.edges.emplace_back(GetEdge(edge));
+                // Всё нужное лямбде собрано в одну структуру: захват одной ссылки не требует памяти в куче
+                struct VisitState {
+                    const TransportRouter& transport_router;
+                    const DirectedWeightedGraph<double>& graph;
+                    const RouteItemVisitor& visitor;
+                } state{ *this, *graph, visitor };
+
+                return router->VisitRoute(start, end, [&state](EdgeId edge) {
+                    std::variant<StopEdge, BusEdge, WalkEdge> item = state.transport_router.GetEdge(edge);
+                    std::visit([&state, edge](auto& route_edge) { route_edge.time = state.graph.GetEdge(edge).weight; }, item);
+                    state.visitor(item);
+                });
+            }
+            // Только время в пути: по меткам хабов, если они есть, иначе по маршрутизатору профиля
+            std::optional<double> TransportRouter::GetRouteTime(VertexId start, VertexId end, std::string_view profile) const {
+                if (IsUnreachable(start, end)) {
+                    return std::nullopt;
+                }
+
+                if (profile.empty() && use_hub_labels_) {
+                    const uint32_t from = vertex_to_terminal_[start];
+                    const uint32_t to = vertex_to_terminal_[end];
+
+                    if (from != NO_TERMINAL && to != NO_TERMINAL) {
+                        return start == end ? std::optional<double>(0.0) : stop_hub_labels_.labels.GetRouteWeight(from, to);
                     }
+                }
 
+                const auto [graph, router] = GetProfileRouter(profile);
+                if (!router) {
+                    return std::nullopt;
+                }
+                return router->GetRouteWeight(start, end);
+            }
+
+            std::vector<RouteInfo> TransportRouter::GetAlternativeRoutes(VertexId start, VertexId end, size_t count, std::string_view profile) const {
+                std::vector<RouteInfo> result;
+
+                if (IsUnreachable(start, end)) {
                     return result;
                 }
+
+                const auto [graph, router] = GetProfileRouter(profile);
+                if (!router) {
+                    return result;
+                }
+
+                const auto shortest = router->BuildRoute(start, end);
+
+                if (!shortest) {
+                    return result;
+                }
+
+                for (const auto& route : FindKShortestPaths(*graph, *shortest, start, end, count, ALTERNATIVE_MAX_STRETCH)) {
+                    result.push_back(MakeRouteInfo(route, *graph));
+                }
+                return result;
+            }
+
+            // Поиск идёт по графу профиля, как и Route. Неизвестный профиль - nullopt
+            std::optional<std::vector<ReachableStop>> TransportRouter::GetReachableStops(VertexId start, double max_time, std::string_view profile) const {
+                const DirectedWeightedGraph<double>* graph = GetProfileGraph(profile);
+                if (!graph) {
+                    return std::nullopt;
+                }
+
+                // Один поиск Дейкстры, прерванный по достижении max_time
+                const auto tree = BuildShortestPathTree(*graph, start, std::optional<double>(max_time));
+                std::vector<ReachableStop> result;
+
+                for (const auto& [stop, vertexes] : stop_to_router_) {
+                    if (tree.IsReachable(vertexes.bus_wait_start)) {
+                        result.push_back({ stop->name_stop, tree.weights[vertexes.bus_wait_start] });
+                    }
+                }
+
+                std::sort(result.begin(), result.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+                    return lhs.time < rhs.time || (lhs.time == rhs.time && lhs.name < rhs.name);
+                });
+                return result;
+            }
+
+            // Таблица всех пар в памяти и метки хабов отвечают на ячейку поиском в таблице. В остальных режимах
+            // (ленивый, флаги дуг, таблица по регионам с оверлеем) на строку - один поиск от начальной остановки,
+            // остановленный на самой дальней из конечных, и все времена строки читаются из его дерева
+            RouteMatrix TransportRouter::GetRouteMatrix(const std::vector<std::optional<VertexId>>& starts, const std::vector<std::optional<VertexId>>& ends) const {
+                RouteMatrix matrix(starts.size(), std::vector<std::optional<double>>(ends.size()));
+
+                size_t region_count = 0;
+                GetVertexRegions(region_count);
+                const bool table_lookups = use_hub_labels_ || (routing_settings_.router_mode == RouterMode::ALL_PAIRS && region_count <= 1);
+
+                for (size_t i = 0; i < starts.size(); ++i) {
+                    if (!starts[i]) {
+                        continue;
+                    }
+
+                    if (table_lookups) {
+                        for (size_t j = 0; j < ends.size(); ++j) {
+                            if (ends[j]) {
+                                matrix[i][j] = GetRouteTime(*starts[i], *ends[j]);
+                            }
+                        }
+                        continue;
+                    }
+
+                    // Цели из других компонент связности не ищутся - иначе поиск обошёл бы всю компоненту начала
+                    std::vector<VertexId> targets;
+                    for (const auto& end : ends) {
+                        if (end && !IsUnreachable(*starts[i], *end)) {
+                            targets.push_back(*end);
+                        }
+                    }
+
+                    const auto tree = BuildShortestPathTreeToTargets(*graph_, *starts[i], targets);
+
+                    for (size_t j = 0; j < ends.size(); ++j) {
+                        if (ends[j] && !IsUnreachable(*starts[i], *ends[j]) && tree.IsReachable(*ends[j])) {
+                            matrix[i][j] = tree.weights[*ends[j]];
+                        }
+                    }
+                }
+                return matrix;
+            }
+
+            // Счётчики кешей основного маршрутизатора и всех построенных профилей вместе
+            RouteCacheStats TransportRouter::GetRouteCacheStats() const {
+                RouteCacheStats result;
+
+                auto add_stats = [&result](const RouterEngine<double>* router) {
+                    if (const auto* cached_router = dynamic_cast<const CachedRouter<double>*>(router)) {
+                        const RouteCacheStats stats = cached_router->GetStats();
+
+                        result.hits += stats.hits;
+                        result.misses += stats.misses;
+                        result.evictions += stats.evictions;
+                        result.size += stats.size;
+                    }
+                };
+
+                add_stats(router_.get());
+
+                std::lock_guard guard(profile_mutex_);
+                for (const auto& [_, profile_router] : profile_routers_) {
+                    add_stats(profile_router.router.get());
+                }
+                return result;
             }
 
             const std::unordered_map<Stop*, RouterByStop>& TransportRouter::GetStopToVertex() const {
                 return stop_to_router_;
             }
-            const std::unordered_map<EdgeId, std::variant<StopEdge, BusEdge>>& TransportRouter::GetEdgeIdToEdge() const {
+            const std::unordered_map<EdgeId, std::variant<StopEdge, BusEdge, WalkEdge>>& TransportRouter::GetEdgeIdToEdge() const {
                 return edge_id_to_edge_;
             }
 
@@ -68,31 +493,178 @@ namespace transport_catalogue {
                 }
                 return stops_ptr;
             }
-            std::deque<Bus*> TransportRouter::GetBusPtr(TransportCatalogue& transport_catalogue) {
-                std::deque<Bus*> buses_ptr;
+            // Автобусы идут в порядке добавления в справочник, а не хеш-таблицы имён
+            std::deque<const Bus*> TransportRouter::GetBusPtr(const TransportCatalogue& transport_catalogue) const {
+                std::deque<const Bus*> buses_ptr;
 
-                for (auto [_, bus_ptr] : transport_catalogue.GetBusnameToBus()) {
-                    buses_ptr.push_back(bus_ptr);
+                for (size_t id = 0; const Bus* bus = transport_catalogue.GetBusById(id); ++id) {
+                    buses_ptr.push_back(bus);
                 }
                 return buses_ptr;
             }
 
+            // Рёбра ожидания добавляются в порядке вершин, а не адресов остановок: номера рёбер одинаковы
+            // при make_base и process_requests, и по ним можно хранить в базе данные о рёбрах.
+            // Рёбра автобусов нумеруются в порядке добавления автобусов, поэтому номера рёбер
+            // в таблице маршрутов и флагах дуг не зависят от хеш-таблиц
             void TransportRouter::AddEdgeToStop() {
-                for (const auto [stop, num] : stop_to_router_) {
+                std::vector<std::pair<Stop*, RouterByStop>> stops(stop_to_router_.begin(), stop_to_router_.end());
+                std::sort(stops.begin(), stops.end(), [](const auto& lhs, const auto& rhs) {
+                    return lhs.second.bus_wait_start < rhs.second.bus_wait_start;
+                });
+
+                for (const auto& [stop, num] : stops) {
                     EdgeId id = graph_->AddEdge(Edge<double>{num.bus_wait_start, num.bus_wait_end, routing_settings_.bus_wait_time}
                     );
 
                     edge_id_to_edge_[id] = StopEdge{ stop->name_stop, routing_settings_.bus_wait_time };
                 }
             }
+            // Пешие пересадки добавляются после рёбер автобусов в порядке из базы, в обе стороны:
+            // от вершины начала ожидания одной остановки к вершине начала ожидания другой
+            void TransportRouter::AddEdgeToWalk(TransportCatalogue& transport_catalogue) {
+                for (const StopWalk& walk : stop_walks_) {
+                    const Stop* first_stop = transport_catalogue.GetStopById(walk.first_id);
+                    const Stop* second_stop = transport_catalogue.GetStopById(walk.second_id);
+                    if (!first_stop || !second_stop) {
+                        continue;
+                    }
+
+                    Stop* first = transport_catalogue.FindStop(first_stop->name_stop);
+                    Stop* second = transport_catalogue.FindStop(second_stop->name_stop);
+                    const double time = ComputeBusTime(walk.distance, routing_settings_.walking_velocity);
+
+                    for (auto [from, to] : { std::make_pair(first, second), std::make_pair(second, first) }) {
+                        const EdgeId id = graph_->AddEdge(Edge<double>{ stop_to_router_.at(from).bus_wait_start, stop_to_router_.at(to).bus_wait_start, time });
+
+                        edge_distances_.resize(id + 1);
+                        edge_distances_[id] = walk.distance;
+                        edge_id_to_edge_[id] = WalkEdge{ from->name_stop, to->name_stop, time };
+                    }
+                }
+            }
+
+            // Рёбра автобусов не зависят друг от друга и строятся параллельно. Каждому автобусу заранее
+            // отведён свой отрезок номеров рёбер (префиксные суммы числа рёбер), потоки пишут только в свои отрезки,
+            // а затем один проход добавляет рёбра в граф - номера и порядок рёбер те же, что при обходе в один поток
             void TransportRouter::AddEdgeToBus(TransportCatalogue& transport_catalogue) {
-                for (auto bus : GetBusPtr(transport_catalogue)) {
-                    ParseBusToEdges(bus->stops_bus.begin(), bus->stops_bus.end(), transport_catalogue, bus);
+                const std::deque<const Bus*> buses = GetBusPtr(transport_catalogue);
+                std::vector<size_t> bus_begin(buses.size() + 1, 0);
+
+                for (size_t i = 0; i < buses.size(); ++i) {
+                    bus_begin[i + 1] = bus_begin[i] + CountBusEdges(buses[i]);
+                }
 
-                    if (!bus->is_roundtrip) {
-                        ParseBusToEdges(bus->stops_bus.rbegin(), bus->stops_bus.rend(), transport_catalogue, bus);
+                std::vector<BusEdgeDraft> drafts(bus_begin.back());
+                std::atomic<size_t> next_bus = 0;
+                std::exception_ptr error;
+                std::mutex error_mutex;
+
+                // Исключение в потоке завершило бы процесс: первое сохраняется, остальные автобусы пропускаются,
+                // и после join исключение пробрасывается дальше
+                auto make_edges = [&]() {
+                    try {
+                        for (size_t i = next_bus++; i < buses.size(); i = next_bus++) {
+                            MakeBusEdges(buses[i], transport_catalogue, drafts.data() + bus_begin[i]);
+                        }
+                    }
+                    catch (...) {
+                        std::lock_guard lock(error_mutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                        next_bus = buses.size();
                     }
+                };
+
+                const size_t thread_count = std::clamp<size_t>(buses.size() / BUSES_PER_THREAD, 1, std::max(std::thread::hardware_concurrency(), 1u));
+                std::vector<std::thread> threads;
+                threads.reserve(thread_count - 1);
+
+                // Если поток не запустился (std::system_error), автобусы разбирают уже запущенные потоки и этот -
+                // исключение не должно уничтожить вектор с незавершёнными потоками
+                try {
+                    for (size_t i = 1; i < thread_count; ++i) {
+                        threads.emplace_back(make_edges);
+                    }
+                }
+                catch (const std::system_error&) {
+                }
+                make_edges();
+                for (auto& thread : threads) {
+                    thread.join();
                 }
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+
+                edge_distances_.resize(graph_->GetEdgeCount() + drafts.size());
+                edge_id_to_edge_.reserve(graph_->GetEdgeCount() + drafts.size());
+
+                for (const auto& draft : drafts) {
+                    const EdgeId id = graph_->AddEdge(draft.edge);
+
+                    edge_distances_[id] = draft.distance;
+                    edge_id_to_edge_[id] = draft.info;
+                }
+            }
+
+            // Рёбра между всеми парами остановок по ходу автобуса, для некольцевого - и в обратную сторону
+            size_t TransportRouter::CountBusEdges(const Bus* bus) const {
+                const size_t stop_count = bus->stops_bus.size();
+                const size_t pairs = stop_count > 1 ? stop_count * (stop_count - 1) / 2 : 0;
+
+                return bus->is_roundtrip ? pairs : 2 * pairs;
+            }
+
+            BusEdgeDraft* TransportRouter::MakeBusEdges(const Bus* bus, const TransportCatalogue& transport_catalogue, BusEdgeDraft* out) const {
+                out = ParseBusToEdges(bus->stops_bus.begin(), bus->stops_bus.end(), transport_catalogue, bus, out);
+
+                if (!bus->is_roundtrip) {
+                    out = ParseBusToEdges(bus->stops_bus.rbegin(), bus->stops_bus.rend(), transport_catalogue, bus, out);
+                }
+                return out;
+            }
+
+            // Порядок обхода хеш-таблицы остановок случаен, и соседние остановки получали далёкие номера вершин.
+            // Нумерация вдоль кривой Гильберта по координатам кладёт близкие остановки рядом во всех массивах по вершинам
+            std::deque<Stop*> TransportRouter::OrderStopsByLocality(std::deque<Stop*> stops) const {
+                if (stops.empty()) {
+                    return stops;
+                }
+
+                auto [min_lat, max_lat] = std::minmax_element(stops.begin(), stops.end(), [](const Stop* lhs, const Stop* rhs) {
+                    return lhs->latitude < rhs->latitude;
+                });
+                auto [min_lng, max_lng] = std::minmax_element(stops.begin(), stops.end(), [](const Stop* lhs, const Stop* rhs) {
+                    return lhs->longitude < rhs->longitude;
+                });
+
+                const double lat_from = (*min_lat)->latitude;
+                const double lng_from = (*min_lng)->longitude;
+                const double lat_span = std::max((*max_lat)->latitude - lat_from, 1e-9);
+                const double lng_span = std::max((*max_lng)->longitude - lng_from, 1e-9);
+                const double cells = static_cast<double>((1u << HILBERT_ORDER) - 1);
+
+                std::vector<std::pair<uint64_t, Stop*>> keyed;
+                keyed.reserve(stops.size());
+
+                for (Stop* stop : stops) {
+                    const auto x = static_cast<uint32_t>((stop->longitude - lng_from) / lng_span * cells);
+                    const auto y = static_cast<uint32_t>((stop->latitude - lat_from) / lat_span * cells);
+                    keyed.push_back({ ComputeHilbertIndex(x, y, HILBERT_ORDER), stop });
+                }
+
+                // Остановки в одной клетке упорядочиваются по имени, чтобы нумерация не зависела от хеш-таблицы
+                std::sort(keyed.begin(), keyed.end(), [](const auto& lhs, const auto& rhs) {
+                    return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second->name_stop < rhs.second->name_stop);
+                });
+
+                std::deque<Stop*> result;
+                for (const auto& [_, stop] : keyed) {
+                    result.push_back(stop);
+                }
+                return result;
             }
 
             void TransportRouter::SetStops(const std::deque<Stop*>& stops) {
@@ -109,10 +681,96 @@ namespace transport_catalogue {
                 const auto stops_ptr_size = GetStopsPtr(transport_catalogue).size();
 
                 graph_ = std::make_unique<DirectedWeightedGraph<double>>(2 * stops_ptr_size);
+                edge_distances_.clear();
 
-                SetStops(GetStopsPtr(transport_catalogue));
+                SetStops(OrderStopsByLocality(GetStopsPtr(transport_catalogue)));
                 AddEdgeToStop();
                 AddEdgeToBus(transport_catalogue);
+                AddEdgeToWalk(transport_catalogue);
+            }
+
+            std::vector<size_t> TransportRouter::GetVertexRegions(size_t& region_count) const {
+                std::vector<size_t> vertex_region(graph_->GetVertexCount());
+                std::unordered_map<std::string_view, size_t> region_to_index;
+
+                for (const auto& [stop, vertexes] : stop_to_router_) {
+                    auto [region_it, _] = region_to_index.insert({ stop->region, region_to_index.size() });
+
+                    vertex_region[vertexes.bus_wait_start] = region_it->second;
+                    vertex_region[vertexes.bus_wait_end] = region_it->second;
+                }
+
+                region_count = region_to_index.size();
+                return vertex_region;
+            }
+
+            // Метки компонент вершин ожидания берутся из базы. Если в базе их нет (или они не сходятся
+            // с числом остановок), метки считаются по графу - это линейный проход
+            void TransportRouter::SetVertexComponents(TransportCatalogue& transport_catalogue) {
+                vertex_components_.assign(graph_->GetVertexCount(), VertexComponent{});
+
+                if (stop_components_.size() != stop_to_router_.size()) {
+                    stop_components_ = ComputeStopComponents(transport_catalogue);
+                }
+
+                for (size_t id = 0; id < stop_components_.size(); ++id) {
+                    const Stop* stop = transport_catalogue.GetStopById(id);
+                    vertex_components_[stop_to_router_.at(transport_catalogue.FindStop(stop->name_stop)).bus_wait_start] = stop_components_[id];
+                }
+            }
+
+            // Время участков берётся из графа профиля, по которому найден маршрут
+            void TransportRouter::SetVertexTerminals(TransportCatalogue& transport_catalogue) {
+                vertex_to_terminal_.clear();
+
+                if (stop_hub_labels_.labels.GetTerminalCount() != stop_to_router_.size() || stop_to_router_.empty()) {
+                    return;
+                }
+
+                vertex_to_terminal_.assign(graph_->GetVertexCount(), NO_TERMINAL);
+                for (uint32_t id = 0; id < stop_hub_labels_.labels.GetTerminalCount(); ++id) {
+                    const Stop* stop = transport_catalogue.GetStopById(id);
+                    vertex_to_terminal_[stop_to_router_.at(transport_catalogue.FindStop(stop->name_stop)).bus_wait_start] = id;
+                }
+            }
+
+            // Флаги дуг берутся из базы. В режиме ARC_FLAGS без подходящих флагов в базе они считаются при старте
+            void TransportRouter::SetVertexCells(TransportCatalogue& transport_catalogue) {
+                vertex_cells_.clear();
+
+                const bool matches = stop_arc_flags_.stop_cells.size() == stop_to_router_.size()
+                    && stop_arc_flags_.edge_flags.size() == graph_->GetEdgeCount();
+
+                if (!matches) {
+                    if (routing_settings_.router_mode != RouterMode::ARC_FLAGS) {
+                        return;
+                    }
+                    stop_arc_flags_ = ComputeStopArcFlags(transport_catalogue);
+                }
+
+                vertex_cells_.assign(graph_->GetVertexCount(), 0);
+                for (size_t id = 0; id < stop_arc_flags_.stop_cells.size(); ++id) {
+                    const Stop* stop = transport_catalogue.GetStopById(id);
+                    const RouterByStop& vertexes = stop_to_router_.at(transport_catalogue.FindStop(stop->name_stop));
+
+                    vertex_cells_[vertexes.bus_wait_start] = stop_arc_flags_.stop_cells[id];
+                    vertex_cells_[vertexes.bus_wait_end] = stop_arc_flags_.stop_cells[id];
+                }
+            }
+
+            RouteInfo TransportRouter::MakeRouteInfo(const RouterEngine<double>::RouteInfo& route, const DirectedWeightedGraph<double>& graph) const {
+                RouteInfo result;
+                result.total_time = route.weight;
+
+                for (const auto edge : route.edges) {
+                    auto& item = result.edges.emplace_back(GetEdge(edge));
+                    std::visit([&graph, edge](auto& route_edge) { route_edge.time = graph.GetEdge(edge).weight; }, item);
+                }
+                return result;
+            }
+
+            double TransportRouter::ComputeBusTime(double distance, double bus_velocity) const {
+                return distance * 1.0 / (bus_velocity * KILOMETER / HOUR);
             }
 
             Edge<double> TransportRouter::MakeEdgeToBus(Stop* start, Stop* end, const double distance) const {
@@ -120,7 +778,7 @@ namespace transport_catalogue {
 
                 result.from = stop_to_router_.at(start).bus_wait_end;
                 result.to = stop_to_router_.at(end).bus_wait_start;
-                result.weight = distance * 1.0 / (routing_settings_.bus_velocity * KILOMETER / HOUR);
+                result.weight = ComputeBusTime(distance, routing_settings_.bus_velocity);
 
                 return result;
             }
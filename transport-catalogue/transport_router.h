@@ -1,12 +1,27 @@
 #pragma once
 
 #include "router.h"
+#include "sharded_router.h"
+#include "lazy_router.h"
+#include "quantized_router.h"
+#include "k_shortest_paths.h"
+#include "components.h"
+#include "hub_labels.h"
+#include "arc_flags.h"
+#include "route_cache.h"
+#include "route_table.h"
 #include "domain.h"
 #include "transport_catalogue.h"
 
 #include <unordered_map>
 #include <variant>
 #include <iterator>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <limits>
+#include <thread>
 
 namespace transport_catalogue {
     namespace detail {
@@ -16,6 +31,12 @@ namespace transport_catalogue {
 
             const int HOUR = 60;
             const int KILOMETER = 1000;
+            const double ALTERNATIVE_MAX_STRETCH = 1.5;    // альтернативные маршруты не дольше лучшего в полтора раза
+            const double DECISECONDS_PER_MINUTE = 600.0;
+            const uint32_t NO_TERMINAL = std::numeric_limits<uint32_t>::max();
+            const int HILBERT_ORDER = 16;                  // порядок кривой Гильберта для нумерации вершин, сетка 2^16 x 2^16
+            const uint32_t ARC_FLAG_GRID = 8;              // ячейки флагов дуг - сетка 8 x 8 по координатам остановок
+            const size_t BUSES_PER_THREAD = 64;            // меньше автобусов на поток рёбра строятся без лишних потоков
 
             struct StopEdge {
                 std::string_view name;
@@ -27,9 +48,55 @@ namespace transport_catalogue {
                 size_t span_count = 0;
                 double time = 0;
             };
+
+            // Пешая пересадка между соседними остановками
+            struct WalkEdge {
+                std::string_view from;
+                std::string_view to;
+                double time = 0;
+            };
+            // Ребро автобуса, подготовленное до добавления в граф
+            struct BusEdgeDraft {
+                Edge<double> edge;
+                double distance = 0.0;
+                BusEdge info;
+            };
+
+            // Способ поиска маршрутов
+            enum class RouterMode {
+                ALL_PAIRS,  // таблица кратчайших путей между всеми парами вершин при старте
+                LAZY,       // дерево кратчайших путей от вершины при первом запросе из неё, с кешем
+                ARC_FLAGS   // поиск от вершины к вершине только по рёбрам, ведущим в ячейку конца маршрута
+            };
+
+            // Тип весов, по которым ищутся маршруты
+            enum class RouteWeight {
+                DOUBLE,         // минуты в double
+                DECISECONDS,    // поиск Дейкстры с монотонной очередью по весу в целых децисекундах; пути и время те же, что у DOUBLE
+                FLOAT           // минуты в float: таблицы вдвое меньше, время в ответе считается по точным весам
+            };
+
+            // Профиль маршрутизации - свои время ожидания и скорость на общем графе остановок
+            struct RoutingProfile {
+                std::string name;
+                double bus_wait_time = 0.0;
+                double bus_velocity = 0.0;
+            };
+
             struct RoutingSettings {
                 double bus_wait_time = 0.0; // время ожидания автобуса на остановке, в минутах.
                 double bus_velocity = 0.0;  // скорость автобуса, в км/ч.
+                RouterMode router_mode = RouterMode::ALL_PAIRS;
+                size_t router_memory_mb = 256;  // лимит памяти под кеш деревьев в режиме LAZY, в мегабайтах.
+                RouteWeight route_weight = RouteWeight::DOUBLE;
+                std::vector<RoutingProfile> profiles;   // именованные профили, выбираются в запросе Route
+                bool hub_labels = false;                // строить при make_base метки хабов для запросов одного времени в пути
+                size_t route_cache_size = 0;            // сколько готовых маршрутов помнить, 0 - без кеша; с кешем параллельные
+                                                        // запросы безопасны в любом режиме, без него - только в ALL_PAIRS
+                double walking_radius = 0.0;            // пешие пересадки между остановками не дальше, в метрах; 0 - без них
+                double walking_velocity = 5.0;          // скорость пешехода, в км/ч
+                std::string route_table_file;           // файл таблицы всех пар для режима ALL_PAIRS, пишется при make_base; пусто - таблица в памяти
+                bool route_table_huge_pages = false;    // просить большие страницы для отображения таблицы из файла
             };
 
             struct RouterByStop {
@@ -39,53 +106,170 @@ namespace transport_catalogue {
 
             struct RouteInfo {
                 double total_time = 0.0;
-                std::vector<std::variant<StopEdge, BusEdge>> edges;
+                std::vector<std::variant<StopEdge, BusEdge, WalkEdge>> edges;
             };
 
+            // Остановка, достижимая за ограниченное время, и время в пути до неё
+            struct ReachableStop {
+                std::string_view name;
+                double time = 0.0;
+            };
+
+            // Компоненты связности вершины графа маршрутизации.
+            // Совпадение strong - путь заведомо есть, различие weak - пути заведомо нет
+            struct VertexComponent {
+                uint32_t strong = NO_COMPONENT;
+                uint32_t weak = NO_COMPONENT;
+
+                static constexpr uint32_t NO_COMPONENT = std::numeric_limits<uint32_t>::max();
+            };
+
+            // Компоненты вершин ожидания остановок, индекс - номер остановки в справочнике.
+            // Считаются при make_base и хранятся в базе
+            using StopComponents = std::vector<VertexComponent>;
+
+            // Пешая пересадка между остановками с номерами из справочника, first_id < second_id.
+            // Пары ищутся при make_base по пространственному индексу и хранятся в базе, рёбра идут в обе стороны
+            struct StopWalk {
+                uint32_t first_id = 0;
+                uint32_t second_id = 0;
+                double distance = 0.0;  // в метрах
+            };
+
+            using StopWalks = std::vector<StopWalk>;
+
+            // Метки хабов вершин ожидания остановок (номер терминала - номер остановки в справочнике)
+            // и основные настройки, по весам которых они построены
+            struct StopHubLabels {
+                HubLabels<double> labels;
+                double bus_wait_time = 0.0;
+                double bus_velocity = 0.0;
+            };
+
+            // Флаги дуг: ячейка каждой остановки (индекс - номер остановки в справочнике), флаги рёбер графа
+            // и основные настройки, по весам которых они построены
+            struct StopArcFlags {
+                std::vector<uint32_t> stop_cells;
+                std::vector<ArcFlags> edge_flags;
+                double bus_wait_time = 0.0;
+                double bus_velocity = 0.0;
+            };
+
+            // Получатель участков маршрута в порядке следования
+            using RouteItemVisitor = std::function<void(const std::variant<StopEdge, BusEdge, WalkEdge>&)>;
+
+            // Матрица времён в пути: строки - начальные остановки, столбцы - конечные
+            using RouteMatrix = std::vector<std::vector<std::optional<double>>>;
+
             class TransportRouter {
             public:
                 void SetRoutingSettings(RoutingSettings routing_settings);
                 const RoutingSettings& GetRoutingSettings() const;
 
+                void SetStopComponents(StopComponents stop_components);
+                StopComponents ComputeStopComponents(TransportCatalogue& transport_catalogue) const;
+
+                void SetStopWalks(StopWalks stop_walks);
+
+                void SetStopHubLabels(StopHubLabels stop_hub_labels);
+                StopHubLabels ComputeStopHubLabels(TransportCatalogue& transport_catalogue) const;
+
+                void SetStopArcFlags(StopArcFlags stop_arc_flags);
+                StopArcFlags ComputeStopArcFlags(TransportCatalogue& transport_catalogue) const;
+                void WriteRouteTable() const;
+
                 void BuildRouter(TransportCatalogue& transport_catalogue);
+                void Customize(RoutingSettings routing_settings);
 
                 const DirectedWeightedGraph<double>& GetGraph() const;
-                const Router<double>& GetRouter() const;
-                const std::variant<StopEdge, BusEdge>& GetEdge(EdgeId id) const;
+                const RouterEngine<double>& GetRouter() const;
+                const std::variant<StopEdge, BusEdge, WalkEdge>& GetEdge(EdgeId id) const;
 
                 std::optional<RouterByStop> GetRouterByStop(Stop* stop) const;
-                std::optional<RouteInfo> GetRouteInfo(VertexId start, VertexId end) const;
+                bool IsUnreachable(VertexId start, VertexId end) const;
+                std::optional<RouteInfo> GetRouteInfo(VertexId start, VertexId end, std::string_view profile = {}) const;
+                std::optional<double> VisitRoute(VertexId start, VertexId end, std::string_view profile, const RouteItemVisitor& visitor) const;
+                std::optional<double> GetRouteTime(VertexId start, VertexId end, std::string_view profile = {}) const;
+                std::vector<RouteInfo> GetAlternativeRoutes(VertexId start, VertexId end, size_t count, std::string_view profile = {}) const;
+                std::optional<std::vector<ReachableStop>> GetReachableStops(VertexId start, double max_time, std::string_view profile = {}) const;
+                RouteMatrix GetRouteMatrix(const std::vector<std::optional<VertexId>>& starts, const std::vector<std::optional<VertexId>>& ends) const;
+                RouteCacheStats GetRouteCacheStats() const;
 
                 const std::unordered_map<Stop*, RouterByStop>& GetStopToVertex() const;
-                const std::unordered_map<EdgeId, std::variant<StopEdge, BusEdge>>& GetEdgeIdToEdge() const;
+                const std::unordered_map<EdgeId, std::variant<StopEdge, BusEdge, WalkEdge>>& GetEdgeIdToEdge() const;
 
                 std::deque<Stop*> GetStopsPtr(TransportCatalogue& transport_catalogue);
-                std::deque<Bus*> GetBusPtr(TransportCatalogue& transport_catalogue);
+                std::deque<const Bus*> GetBusPtr(const TransportCatalogue& transport_catalogue) const;
 
                 void AddEdgeToStop();
                 void AddEdgeToBus(TransportCatalogue& transport_catalogue);
+                void AddEdgeToWalk(TransportCatalogue& transport_catalogue);
 
+                std::deque<Stop*> OrderStopsByLocality(std::deque<Stop*> stops) const;
                 void SetStops(const std::deque<Stop*>& stops);
                 void SetGraph(TransportCatalogue& transport_catalogue);
+                std::vector<size_t> GetVertexRegions(size_t& region_count) const;
+                void SetVertexComponents(TransportCatalogue& transport_catalogue);
+                void SetVertexTerminals(TransportCatalogue& transport_catalogue);
+                void SetVertexCells(TransportCatalogue& transport_catalogue);
 
+                double ComputeBusTime(double distance, double bus_velocity) const;
                 Edge<double> MakeEdgeToBus(Stop* start, Stop* end, const double distance) const;
+                RouteInfo MakeRouteInfo(const RouterEngine<double>::RouteInfo& route, const DirectedWeightedGraph<double>& graph) const;
+
+                size_t CountBusEdges(const Bus* bus) const;
+                BusEdgeDraft* MakeBusEdges(const Bus* bus, const TransportCatalogue& transport_catalogue, BusEdgeDraft* out) const;
 
                 template <typename Iterator>
-                void ParseBusToEdges(Iterator first, Iterator last, const TransportCatalogue& transport_catalogue, const Bus* bus);
+                BusEdgeDraft* ParseBusToEdges(Iterator first, Iterator last, const TransportCatalogue& transport_catalogue, const Bus* bus, BusEdgeDraft* out) const;
+
+                template <typename Weight>
+                std::unique_ptr<RouterEngine<Weight>> MakeEngine(const DirectedWeightedGraph<Weight>& graph, std::vector<size_t> vertex_region, size_t region_count) const;
 
             private:
+                // Граф с весами профиля и маршрутизатор по нему. Остановки, рёбра и их описания общие для всех профилей.
+                // Маршрутизатор строится при первом запросе маршрута: изохроне нужен только граф
+                struct ProfileRouter {
+                    std::unique_ptr<DirectedWeightedGraph<double>> graph;
+                    std::unique_ptr<RouterEngine<double>> router;
+                };
+
+                double ComputeEdgeWeight(EdgeId id, const std::variant<StopEdge, BusEdge, WalkEdge>& edge, double bus_wait_time, double bus_velocity) const;
+                void ApplyMetric();
+                void BuildEngine();
+                std::unique_ptr<RouterEngine<double>> MakeRouter(const DirectedWeightedGraph<double>& graph) const;
+                ProfileRouter* FindProfileRouter(std::string_view profile) const;
+                const DirectedWeightedGraph<double>* GetProfileGraph(std::string_view profile) const;
+                std::pair<const DirectedWeightedGraph<double>*, const RouterEngine<double>*> GetProfileRouter(std::string_view profile) const;
 
                 std::unordered_map<Stop*, RouterByStop> stop_to_router_;
-                std::unordered_map<EdgeId, std::variant<StopEdge, BusEdge>> edge_id_to_edge_;
+                std::unordered_map<EdgeId, std::variant<StopEdge, BusEdge, WalkEdge>> edge_id_to_edge_;
+                std::vector<double> edge_distances_;    // длина в метрах для рёбер автобусов и пеших - по ней пересчитываются веса
+                StopWalks stop_walks_;
 
                 std::unique_ptr<DirectedWeightedGraph<double>> graph_;
-                std::unique_ptr<Router<double>> router_;
+                std::unique_ptr<RouterEngine<double>> router_;
+                // Маршрутизаторы профилей строятся при первом запросе профиля, под profile_mutex_
+                mutable std::unordered_map<std::string, ProfileRouter> profile_routers_;
+                mutable std::mutex profile_mutex_;
+
+                StopComponents stop_components_;
+                std::vector<VertexComponent> vertex_components_;
+
+                StopHubLabels stop_hub_labels_;
+                std::vector<uint32_t> vertex_to_terminal_;  // номер метки для вершины ожидания остановки
+                bool use_hub_labels_ = false;               // метки есть и построены по текущим весам
+
+                StopArcFlags stop_arc_flags_;
+                std::vector<uint32_t> vertex_cells_;
+                bool use_arc_flags_ = false;                // флаги есть и построены по текущим весам
 
                 RoutingSettings routing_settings_;
             };
 
+            // Рёбра пишутся подряд с out, возвращается конец записанного. Граф не меняется - можно звать из разных потоков
             template <typename Iterator>
-            void TransportRouter::ParseBusToEdges(Iterator first, Iterator last, const TransportCatalogue& transport_catalogue, const Bus* bus) {
+            BusEdgeDraft* TransportRouter::ParseBusToEdges(Iterator first, Iterator last, const TransportCatalogue& transport_catalogue, const Bus* bus, BusEdgeDraft* out) const {
 
                 for (auto it = first; it != last; ++it) {
                     size_t distance = 0;
@@ -95,11 +279,29 @@ namespace transport_catalogue {
                         distance += transport_catalogue.GetDistanceStop(*prev(it2), *it2);
                         ++span;
 
-                        EdgeId id = graph_->AddEdge(MakeEdgeToBus(*it, *it2, distance));
-
-                        edge_id_to_edge_[id] = BusEdge{ bus->name_bus, span, graph_->GetEdge(id).weight };
+                        out->edge = MakeEdgeToBus(*it, *it2, distance);
+                        out->distance = distance;
+                        out->info = BusEdge{ bus->name_bus, span, out->edge.weight };
+                        ++out;
                     }
                 }
+                return out;
+            }
+
+            // Таблицы маршрутов строятся конструктором, повторный Build() не нужен.
+            // Ленивому маршрутизатору разбиение на регионы не требуется - он не хранит таблицу всех пар.
+            // Флаги дуг годятся только для основного графа, для остальных режим ARC_FLAGS работает как LAZY
+            template <typename Weight>
+            std::unique_ptr<RouterEngine<Weight>> TransportRouter::MakeEngine(const DirectedWeightedGraph<Weight>& graph, std::vector<size_t> vertex_region, size_t region_count) const {
+                if (routing_settings_.router_mode != RouterMode::ALL_PAIRS) {
+                    return std::make_unique<LazyRouter<Weight>>(graph, routing_settings_.router_memory_mb * 1024 * 1024);
+                }
+                else if (region_count > 1) {
+                    return std::make_unique<ShardedRouter<Weight>>(graph, std::move(vertex_region), region_count);
+                }
+                else {
+                    return std::make_unique<Router<Weight>>(graph);
+                }
             }
         }
     }